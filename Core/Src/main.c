@@ -70,6 +70,8 @@ int main(void)
   /* USER CODE BEGIN 1 */
 
 	BL_Stat_t BL_Stat = BL_NACK;
+	/* Jump to the application right away unless the bootloader has to run */
+	BL_Boot_Early_Decision();
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -84,6 +86,7 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+	BL_Timing_Boot_Stamp(BL_BOOT_TS_CLOCK_READY);
 
   /* USER CODE END SysInit */
 
@@ -93,6 +96,7 @@ int main(void)
   MX_USART1_UART_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
+	BL_Timing_Boot_Stamp(BL_BOOT_TS_PERIPHERALS_READY);
 
   /* USER CODE END 2 */
 
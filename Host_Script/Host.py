@@ -3,7 +3,13 @@ import struct
 import os
 import sys
 import glob
-from time import sleep
+import hashlib
+import re
+import argparse
+import json
+import contextlib
+import multiprocessing
+from time import monotonic, sleep
 
 ''' Bootloader Commands '''
 CBL_GET_VER_CMD              = 0x10
@@ -14,6 +20,19 @@ CBL_GO_TO_ADDR_CMD           = 0x14
 CBL_FLASH_ERASE_CMD          = 0x15
 CBL_MEM_WRITE_CMD            = 0x16
 CBL_CHANGE_ROP_Level_CMD     = 0x17
+CBL_GET_SHA256_CMD           = 0x18
+CBL_SECTOR_MANIFEST_CMD      = 0x19
+CBL_SLOT_INFO_CMD            = 0x1A
+CBL_GET_TIMING_CMD           = 0x1B
+CBL_EXEC_RAM_STUB_CMD        = 0x1C
+CBL_MEM_READ_CMD             = 0x1D
+CBL_MEM_DUMP_CMD             = 0x1E
+CBL_BLANK_CHECK_CMD          = 0x1F
+CBL_BLOCK_DIFF_CMD           = 0x20
+CBL_GET_DEVICE_INFO_CMD      = 0x21
+CBL_SESSION_OPEN_CMD         = 0x22
+
+ADDRESS_NOT_BOOTABLE         = 0x02
 
 INVALID_SECTOR_NUMBER        = 0x00
 VALID_SECTOR_NUMBER          = 0x01
@@ -23,14 +42,163 @@ SUCCESSFUL_ERASE             = 0x03
 FLASH_PAYLOAD_WRITE_FAILED   = 0x00
 FLASH_PAYLOAD_WRITE_PASSED   = 0x01
 
-verbose_mode = 1
-Memory_Write_Active = 0
+SHA256_MODE_REGION           = 0x00
+SHA256_MODE_WRITE_STREAM     = 0x01
+
+MANIFEST_OP_READ             = 0x00
+MANIFEST_OP_VALIDATE         = 0x01
+MANIFEST_OP_COMMIT           = 0x02
+MANIFEST_REQUEST_VALID       = 0x01
+
+MANIFEST_SECTOR_UNKNOWN      = 0x00
+MANIFEST_SECTOR_MATCH        = 0x01
+MANIFEST_SECTOR_MISMATCH     = 0x02
+
+MEM_READ_INVALID_ADDRESS     = 0x00
+MEM_READ_PASSED              = 0x01
+MEM_READ_RDP_ACTIVE          = 0x02
+''' status + data + CRC must fit the one byte ACK length '''
+MEM_READ_MAX_LENGTH          = 250
+
+''' Dump control frames : type + block index + CRC '''
+DUMP_CTRL_ACK                = 0x01
+DUMP_CTRL_RETRANSMIT         = 0x02
+DUMP_CTRL_ABORT              = 0x03
+DUMP_MAX_WINDOW              = 16
+DUMP_MAX_RETRIES             = 5
+
+BLANK_CHECK_INVALID_ADDRESS  = 0x00
+BLANK_CHECK_BLANK            = 0x01
+BLANK_CHECK_NOT_BLANK        = 0x02
+
+DIFF_PASSED                  = 0x01
+DIFF_BLOCK_SIZE              = 1024
+''' (block index , CRC) pairs per request , one frame '''
+DIFF_MAX_PAIRS               = 40
+
+''' Device info feature flags '''
+FEATURE_NAMES                = ['Dual Slot', 'Host TX DMA', 'Host RX DMA', 'RDP Level 2', 'Validation Cache', 'Boot Strap',
+                                'Word CRC', 'Compression']
+
+''' Session parameters , the defaults are the protocol without a session '''
+MAX_FRAME_SIZE               = 256
+SESSION_CRC_BYTE             = 0x00
+SESSION_CRC_WORD             = 0x01
+SESSION_OPENED               = 0x01
+''' rate set by MX_USART2_UART_Init , the first of BL_HOST_BAUD_RATES '''
+DEFAULT_BAUD_RATE            = 115200
+''' BL_SESSION_IDLE_TIMEOUT_MS , the bootloader closes a session this long without a frame '''
+SESSION_IDLE_TIMEOUT         = 5.0
+''' both ends start the idle timer at slightly different times , closer than this to the timeout is not trusted '''
+SESSION_IDLE_MARGIN          = 0.25
+
+SLOT_OP_READ                 = 0x00
+SLOT_OP_CLEAR_ATTEMPTS       = 0x01
+
+''' STM32F401CC flash layout , the application starts at sector 4 '''
+FLASH_BASE_ADDRESS           = 0x08000000
+FLASH_SECTOR_SIZES           = [0x4000, 0x4000, 0x4000, 0x4000, 0x10000, 0x20000]
+''' Typical erase time of each sector in seconds (x32 parallelism) '''
+FLASH_SECTOR_ERASE_TIMES     = [0.25, 0.25, 0.25, 0.25, 0.55, 1.0]
+APP_FIRST_SECTOR             = 4
+APP_BASE_ADDRESS             = 0x08010000
+
+''' Dual slot images (BL_ENABLE_DUAL_SLOT) , slot A -> sector 4 , slot B -> sector 5 '''
+SLOT_BASE_ADDRESSES          = [0x08010000, 0x08020000]
+SLOT_NAMES                   = ['A', 'B']
+''' boot attempts of a slot whose image used them all up , skipped until a new image is written '''
+SLOT_REJECTED                = 0xFF
+NO_SLOT                      = 0xFF
+
+''' Image header stamped in front of Application.bin , the vector table follows at IMAGE_HEADER_SIZE '''
+IMAGE_HEADER_MAGIC           = 0x474D4942
+IMAGE_HEADER_VERSION         = 1
+IMAGE_HEADER_SIZE            = 0x200
+
+''' RAM stubs run from the upper 32K of SRAM and start with a 6 word header (see Bootloader_Stub.h) '''
+STUB_RAM_BASE                = 0x20008000
+STUB_RAM_SIZE                = 0x8000
+STUB_MAGIC                   = 0x42555453
+STUB_API_VERSION             = 1
+STUB_HEADER_SIZE             = 24
+
+''' Core clock of the bootloader, used to convert reported cycles '''
+BL_CPU_CLOCK_HZ              = 84000000
+
+BOOT_TIMESTAMP_NAMES         = ['Reset', 'Clock Ready', 'Peripherals Ready', 'Application Jump']
+TIMING_PHASE_NAMES           = ['Receive', 'CRC', 'Flash', 'Reply']
+
+''' Deadline in seconds for the complete reply (ACK + data) of one frame , commands doing flash work get longer '''
+RESPONSE_DEADLINE            = 1.0
+RESPONSE_DEADLINES           = {CBL_FLASH_ERASE_CMD : 10.0, CBL_GET_SHA256_CMD : 4.0, CBL_CHANGE_ROP_Level_CMD : 5.0,
+                                CBL_BLOCK_DIFF_CMD : 2.0, CBL_BLANK_CHECK_CMD : 2.0}
+''' A frame is resent on timeout or NACK , except the ones that leave the bootloader or change the link
+    and the memory dump , whose blocks may already be streaming when the reply times out .
+    A resent memory write whose reply was lost is folded into the write stream SHA-256 once ,
+    the bootloader skips a frame repeating the previous address , length and frame CRC '''
+FRAME_MAX_RETRIES            = 3
+NO_RETRY_COMMANDS            = [CBL_GO_TO_ADDR_CMD, CBL_EXEC_RAM_STUB_CMD, CBL_CHANGE_ROP_Level_CMD, CBL_SESSION_OPEN_CMD,
+                                CBL_MEM_DUMP_CMD]
+''' Quiet time before a resend , longer than BL_HOST_FRAME_TIMEOUT_MS so a partial frame is dropped by then '''
+FRAME_RESYNC_TIME            = 0.06
+''' 0xFF runs at least this long inside a flash segment are not sent , erased flash already holds them '''
+SPARSE_MIN_ERASED_RUN        = 64
+
+''' Progress of a transfer is kept next to the image , saved every PROGRESS_SAVE_FRAMES acknowledged frames '''
+PROGRESS_FILE_SUFFIX         = '.progress.json'
+PROGRESS_SAVE_FRAMES         = 16
+
+''' Linux device nodes probed for a bootloader : FTDI / CP210x adapters , USB CDC (ST-LINK VCP) and on board UARTs '''
+LINUX_SERIAL_PORT_PATTERNS   = ['/dev/ttyUSB*', '/dev/ttyACM*', '/dev/ttyAMA*']
+''' pseudo-terminals a simulated bootloader (or socat) listens on , listed but never opened while probing '''
+LINUX_PTY_PORT_PATTERNS      = ['/dev/pts/[0-9]*']
+''' usb-serial adapters buffer short replies up to this many ms by default , 1 ms is the minimum '''
+USB_SERIAL_LATENCY_TIMER     = '/sys/bus/usb-serial/devices/{0}/latency_timer'
+
+''' Upper edges of the round trip time histogram buckets in ms , the last bucket takes the rest '''
+RTT_HISTOGRAM_EDGES_MS       = [0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000]
+
+''' Exit codes of the command line interface , usage errors exit with 2 from argparse '''
+EXIT_OK                      = 0
+EXIT_FAILED                  = 1
+EXIT_USAGE                   = 2
+EXIT_NO_RESPONSE             = 3
+
+''' Dump blocks stream back to back , this long without a block is a loss '''
+DUMP_BLOCK_TIMEOUT           = 0.5
+
+''' Trace every frame written / read as hex , off by default since printing costs more than the link '''
+verbose_mode = 0
+SHA256_Hashed_Length = 0
+SHA256_Digest = None
+Unanswered_Frames = 0
+Response_Deadline = 0
+Timing_Print_Boot = 1
+Memory_Read_Data = None
+Dump_Reply = None
+Blank_Check_Result = None
+Block_Diff_Bitmap = None
+Flash_Erase_Status = None
+Device_Info = None
+Manifest_Status = None
+DEFAULT_SESSION = {'Open' : 0, 'Frame_Size' : MAX_FRAME_SIZE, 'Window' : DUMP_MAX_WINDOW, 'CRC_Mode' : SESSION_CRC_BYTE, 'Compression' : 0}
+Session = dict(DEFAULT_SESSION)
+''' last frame written or reply read , the bootloader idle timer runs from about then '''
+Link_Last_Activity = 0
 
 def Check_Serial_Ports():
     Serial_Ports = []
     
+    Pseudo_Terminals = []
+    
     if sys.platform.startswith('win'):
         Ports = ['COM%s' % (i + 1) for i in range(256)]
+    elif sys.platform.startswith('linux'):
+        Ports = [Port for Pattern in LINUX_SERIAL_PORT_PATTERNS for Port in sorted(glob.glob(Pattern))]
+        ''' opening a pty would switch whatever terminal owns it to raw mode , so they are only listed '''
+        Own_Terminal = os.ttyname(sys.stdin.fileno()) if sys.stdin.isatty() else None
+        Pseudo_Terminals = [Port for Pattern in LINUX_PTY_PORT_PATTERNS for Port in sorted(glob.glob(Pattern), key = len)
+                            if Port != Own_Terminal]
     else:
         raise EnvironmentError("Error !! Unsupported Platform \n")
     
@@ -42,12 +210,28 @@ def Check_Serial_Ports():
         except (OSError, serial.SerialException):
             pass
     
-    return Serial_Ports
+    return Serial_Ports + Pseudo_Terminals
+
+def Set_Low_Latency_Mode():
+    ''' replies are a few bytes , the driver must hand them over at once instead of batching them '''
+    try:
+        Serial_Port_Obj.set_low_latency_mode(True)
+    except (AttributeError, ValueError, OSError):
+        ''' Windows ports , pseudo-terminals and URLs have no ASYNC_LOW_LATENCY flag '''
+        pass
+    Latency_Timer = USB_SERIAL_LATENCY_TIMER.format(os.path.basename(os.path.realpath(str(Serial_Port_Obj.port))))
+    try:
+        with open(Latency_Timer, 'w') as Latency_Timer_File:
+            Latency_Timer_File.write('1')
+    except OSError:
+        ''' not a usb-serial adapter or no write access , the 16 ms default stays '''
+        pass
 
 def Serial_Port_Configuration(Port_Number):
     global Serial_Port_Obj
     try:
-        Serial_Port_Obj = serial.Serial(Port_Number, 115200, timeout = 2)
+        ''' a URL (socket:// , loop:// ...) reaches a simulated target the same way as a device name '''
+        Serial_Port_Obj = serial.serial_for_url(Port_Number, DEFAULT_BAUD_RATE, timeout = 2)
     except:
         print("\nError !! That was not a valid port")
     
@@ -61,37 +245,183 @@ def Serial_Port_Configuration(Port_Number):
     
     if Serial_Port_Obj.is_open:
         print("Port Open Success \n")
+        Set_Low_Latency_Mode()
+        ''' the metrics cover one port session '''
+        global Link_Metrics
+        Link_Metrics = New_Link_Metrics()
+        Session.update(DEFAULT_SESSION)
     else:
         print("Port Open Failed \n")
 
-def Write_Data_To_Serial_Port(Value, Length):
-    _data = struct.pack('>B', Value)
+def Trace_Serial_Data(Direction, Data):
     if(verbose_mode):
-        Value = bytearray(_data)
-        print("   "+"0x{:02x}".format(Value[0]), end = ' ')
-        if(Memory_Write_Active and (not verbose_mode)):
-            print("#", end = ' ')
-        Serial_Port_Obj.write(_data)
+        print("\n   " + Direction + " " + ' '.join("0x{:02x}".format(Data_Byte) for Data_Byte in Data))
+
+def Write_Packet_To_Serial_Port(Packet):
+    ''' the whole frame goes out in one write , one syscall and one USB transfer per packet '''
+    Start_Time = monotonic()
+    Packet = bytes(Packet)
+    Trace_Serial_Data("TX", Packet)
+    Write_Time = monotonic()
+    Serial_Port_Obj.write(Packet)
+    Attempt = Link_Metrics['Attempt']
+    Attempt['Serialize'] = Write_Time - Start_Time
+    Attempt['Write_End'] = monotonic()
+    global Link_Last_Activity
+    Link_Last_Activity = Attempt['Write_End']
+    Attempt['Write'] = Attempt['Write_End'] - Write_Time
+    Attempt['Ack'] = None
+    Link_Metrics['Frames'] += 1
+    Link_Metrics['Bytes_Out'] += len(Packet)
+
+def New_Link_Metrics():
+    return {'Start' : monotonic(), 'Frames' : 0, 'Retries' : 0, 'Bytes_Out' : 0, 'Bytes_In' : 0,
+            'Payload_Bytes' : 0, 'Payload_Time' : 0.0, 'Build_Time' : 0.0, 'Commands' : {}, 'Attempt' : {}}
+
+Link_Metrics = New_Link_Metrics()
+
+def Metrics_Command_Done(Command_Code, Command_Start, Attempts, Passed):
+    ''' one Send_Command_Frame transaction , the phases come from its last attempt '''
+    Done_Time = monotonic()
+    Command = Link_Metrics['Commands'].setdefault(Command_Code, {'Count' : 0, 'Failed' : 0, 'Retries' : 0, 'Latency' : [], 'RTT' : [],
+                                                                 'Serialize' : 0.0, 'Write' : 0.0, 'Ack_Wait' : 0.0, 'Reply' : 0.0})
+    Command['Count'] += 1
+    Command['Retries'] += Attempts - 1
+    Link_Metrics['Retries'] += Attempts - 1
+    Command['Latency'].append(Done_Time - Command_Start)
+    Attempt = Link_Metrics['Attempt']
+    if(Passed and Attempt['Ack']):
+        Command['RTT'].append(Done_Time - Attempt['Write_End'])
+        Command['Serialize'] += Attempt['Serialize']
+        Command['Write'] += Attempt['Write']
+        Command['Ack_Wait'] += Attempt['Ack'] - Attempt['Write_End']
+        Command['Reply'] += Done_Time - Attempt['Ack']
+    elif(not Passed):
+        Command['Failed'] += 1
+
+def Summarize_Times(Samples):
+    if(not Samples):
+        return None
+    Sorted = sorted(Samples)
+    return {'mean_ms' : round(1000 * sum(Sorted) / len(Sorted), 3),
+            'p50_ms'  : round(1000 * Sorted[len(Sorted) // 2], 3),
+            'p95_ms'  : round(1000 * Sorted[min(len(Sorted) - 1, (len(Sorted) * 95) // 100)], 3),
+            'max_ms'  : round(1000 * Sorted[-1], 3)}
+
+def RTT_Histogram(Samples):
+    Buckets = ["<={0}ms".format(Edge) for Edge in RTT_HISTOGRAM_EDGES_MS] + [">{0}ms".format(RTT_HISTOGRAM_EDGES_MS[-1])]
+    Histogram = dict.fromkeys(Buckets, 0)
+    for Sample in Samples:
+        Bucket = next((Index for Index, Edge in enumerate(RTT_HISTOGRAM_EDGES_MS) if (Sample * 1000) <= Edge), len(RTT_HISTOGRAM_EDGES_MS))
+        Histogram[Buckets[Bucket]] += 1
+    return Histogram
+
+def Link_Metrics_Report():
+    ''' JSON ready summary of the port session , RTT runs from the end of the frame write to the processed reply '''
+    Elapsed = monotonic() - Link_Metrics['Start']
+    Command_Names = {Value : Name for Name, Value in globals().items() if Name.startswith('CBL_') and Name.endswith('_CMD')}
+    Commands = {}
+    for Command_Code, Command in Link_Metrics['Commands'].items():
+        Passed = len(Command['RTT'])
+        Commands[Command_Names.get(Command_Code, hex(Command_Code))] = {
+            'count' : Command['Count'], 'failed' : Command['Failed'], 'retries' : Command['Retries'],
+            'latency' : Summarize_Times(Command['Latency']),
+            'rtt' : Summarize_Times(Command['RTT']),
+            'rtt_histogram' : RTT_Histogram(Command['RTT']),
+            'phases_mean_ms' : {Phase.lower() : round(1000 * Command[Phase] / Passed, 3) if Passed else None
+                                for Phase in ('Serialize', 'Write', 'Ack_Wait', 'Reply')}}
+    return {'elapsed_s' : round(Elapsed, 3),
+            'baud_rate' : Serial_Port_Obj.baudrate if('Serial_Port_Obj' in globals()) else None,
+            'frame_size' : Session['Frame_Size'] if Session['Open'] else None,
+            'frames' : Link_Metrics['Frames'],
+            'retries' : Link_Metrics['Retries'],
+            'failed_commands' : sum(Command['Failed'] for Command in Link_Metrics['Commands'].values()),
+            'bytes_out' : Link_Metrics['Bytes_Out'],
+            'bytes_in' : Link_Metrics['Bytes_In'],
+            'wire_bytes_per_s' : round((Link_Metrics['Bytes_Out'] + Link_Metrics['Bytes_In']) / Elapsed, 1) if Elapsed else None,
+            'payload_bytes' : Link_Metrics['Payload_Bytes'],
+            'payload_bytes_per_s' : round(Link_Metrics['Payload_Bytes'] / Link_Metrics['Payload_Time'], 1) if Link_Metrics['Payload_Time'] else None,
+            'frame_build_s' : round(Link_Metrics['Build_Time'], 4),
+            'commands' : Commands}
+
+def Save_Link_Metrics(File_Name):
+    with open(File_Name, 'w') as Metrics_File:
+        json.dump(Link_Metrics_Report(), Metrics_File, indent = 2)
+
+class BL_Response_Error(Exception):
+    pass
+
+class BL_Response_Timeout(BL_Response_Error):
+    ''' the deadline ran out , unlike a NACK the bootloader did not answer at all '''
+    pass
 
 def Read_Serial_Port(Data_Len):
-    
-    Serial_Value = Serial_Port_Obj.read(Data_Len)
-    Serial_Value_len = len(Serial_Value)
-    while Serial_Value_len <= 0:
-        Serial_Value = Serial_Port_Obj.read(Data_Len)
-        Serial_Value_len = len(Serial_Value)
-        print("Waiting Replay from the Bootloader")
+    ''' exactly Data_Len bytes before the deadline of the current command , BL_Response_Error otherwise '''
+    global Link_Last_Activity
+    Serial_Value = b''
+    while(len(Serial_Value) < Data_Len):
+        Remaining = Response_Deadline - monotonic()
+        if(Remaining <= 0):
+            Trace_Serial_Data("RX", Serial_Value)
+            Link_Last_Activity = monotonic()
+            raise BL_Response_Timeout("Timeout !!, Bootloader is not responding")
+        Serial_Port_Obj.timeout = Remaining
+        Serial_Value += Serial_Port_Obj.read(Data_Len - len(Serial_Value))
+    Link_Last_Activity = monotonic()
+    Trace_Serial_Data("RX", Serial_Value)
+    Link_Metrics['Bytes_In'] += len(Serial_Value)
     return Serial_Value
-    
-    '''
-    Serial_Value = Serial_Port_Obj.read(Data_Len)
-    return Serial_Value
-    '''
+
+def Resync_Serial_Port():
+    ''' drop whatever is still arriving and let the bootloader time out a partial frame '''
+    Serial_Port_Obj.timeout = FRAME_RESYNC_TIME
+    while(len(Serial_Port_Obj.read(256))):
+        pass
+
+def Clear_Command_Results():
+    global Memory_Read_Data, Dump_Reply, Blank_Check_Result, Block_Diff_Bitmap, Flash_Erase_Status, Device_Info
+    global Memory_Write_All, SHA256_Digest, Manifest_Status
+    SHA256_Digest = None
+    Manifest_Status = None
+    Memory_Read_Data = None
+    Dump_Reply = None
+    Blank_Check_Result = None
+    Block_Diff_Bitmap = None
+    Flash_Erase_Status = None
+    Device_Info = None
+    Memory_Write_All = 0
+
+def Send_Command_Frame(Packet, Command_Code):
+    ''' one command transaction , 1 once the reply was processed , 0 after the last retry failed '''
+    Retry_Limit = 0 if(Command_Code in NO_RETRY_COMMANDS) else FRAME_MAX_RETRIES
+    Command_Start = monotonic()
+    Timed_Out = 0
+    for Attempt in range(Retry_Limit + 1):
+        if(Attempt):
+            print("\n   Resending the frame , retry", Attempt, "of", Retry_Limit)
+            Resync_Serial_Port()
+        Write_Packet_To_Serial_Port(Packet)
+        try:
+            Read_Data_From_Serial_Port(Command_Code)
+            Metrics_Command_Done(Command_Code, Command_Start, Attempt + 1, 1)
+            return 1
+        except BL_Response_Error as Response_Error:
+            print("\n   Error !!", Response_Error)
+            Timed_Out = isinstance(Response_Error, BL_Response_Timeout)
+    Metrics_Command_Done(Command_Code, Command_Start, Retry_Limit + 1, 0)
+    global Unanswered_Frames
+    if(Timed_Out):
+        Unanswered_Frames += 1
+    Clear_Command_Results()
+    return 0
 
 def Read_Data_From_Serial_Port(Command_Code):
+    global Response_Deadline
     Length_To_Follow = 0
+    Response_Deadline = monotonic() + RESPONSE_DEADLINES.get(Command_Code, RESPONSE_DEADLINE)
     
     BL_ACK = Read_Serial_Port(2)
+    Link_Metrics['Attempt']['Ack'] = monotonic()
     if(len(BL_ACK)):
         BL_ACK_Array = bytearray(BL_ACK)
         if(BL_ACK_Array[0] == 0xCD):
@@ -114,9 +444,30 @@ def Read_Data_From_Serial_Port(Command_Code):
                 Process_CBL_MEM_WRITE_CMD(Length_To_Follow)
             elif (Command_Code == CBL_CHANGE_ROP_Level_CMD):
                 Process_CBL_CHANGE_ROP_Level_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_GET_SHA256_CMD):
+                Process_CBL_GET_SHA256_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_SECTOR_MANIFEST_CMD):
+                Process_CBL_SECTOR_MANIFEST_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_SLOT_INFO_CMD):
+                Process_CBL_SLOT_INFO_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_GET_TIMING_CMD):
+                Process_CBL_GET_TIMING_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_EXEC_RAM_STUB_CMD):
+                Process_CBL_EXEC_RAM_STUB_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_MEM_READ_CMD):
+                Process_CBL_MEM_READ_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_MEM_DUMP_CMD):
+                Process_CBL_MEM_DUMP_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_BLANK_CHECK_CMD):
+                Process_CBL_BLANK_CHECK_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_BLOCK_DIFF_CMD):
+                Process_CBL_BLOCK_DIFF_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_GET_DEVICE_INFO_CMD):
+                Process_CBL_GET_DEVICE_INFO_CMD(Length_To_Follow)
+            elif (Command_Code == CBL_SESSION_OPEN_CMD):
+                Process_CBL_SESSION_OPEN_CMD(Length_To_Follow)
         else:
-            print ("\n   Received Not-Acknowledgement from Bootloader")
-            sys.exit()
+            raise BL_Response_Error("Received Not-Acknowledgement from Bootloader")
         
 def Process_CBL_GET_VER_CMD(Data_Len):
     Serial_Data = Read_Serial_Port(Data_Len)
@@ -153,14 +504,19 @@ def Process_CBL_GO_TO_ADDR_CMD(Data_Len):
     _value_ = bytearray(Serial_Data)
     if(_value_[0] == 1):
         print("\n   Address Status is Valid")
+    elif(_value_[0] == ADDRESS_NOT_BOOTABLE):
+        print("\n   Address Status -> No bootable image there , or not the slot the bootloader would start")
     else:
         print("\n   Address Status is InValid")
 
 def Process_CBL_FLASH_ERASE_CMD(Data_Len):
+    global Flash_Erase_Status
     BL_Erase_Status = 0
+    Flash_Erase_Status = None
     Serial_Data = Read_Serial_Port(Data_Len)
     if(len(Serial_Data)):
         BL_Erase_Status = bytearray(Serial_Data)
+        Flash_Erase_Status = BL_Erase_Status[0]
         if(BL_Erase_Status[0] == INVALID_SECTOR_NUMBER):
             print("\n   Erase Status -> Invalid Sector Number ")
         elif (BL_Erase_Status[0] == UNSUCCESSFUL_ERASE):
@@ -179,6 +535,7 @@ def Process_CBL_MEM_WRITE_CMD(Data_Len):
     BL_Write_Status = bytearray(Serial_Data)
     if(BL_Write_Status[0] == FLASH_PAYLOAD_WRITE_FAILED):
         print("\n   Write Status -> Write Failed or Invalid Address ")
+        Memory_Write_All = 0
     elif (BL_Write_Status[0] == FLASH_PAYLOAD_WRITE_PASSED):
         print("\n   Write Status -> Write Successfule ")
         Memory_Write_All = Memory_Write_All and FLASH_PAYLOAD_WRITE_PASSED
@@ -197,6 +554,310 @@ def Process_CBL_CHANGE_ROP_Level_CMD(Data_Len):
         else:
             print("\n   ROP Level -> Unknown Error")
 
+def Process_CBL_GET_SHA256_CMD(Data_Len):
+    global SHA256_Digest
+    SHA256_Digest = None
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] == MEM_READ_RDP_ACTIVE):
+        print("\n   SHA-256 Status -> Refused , read protection is active ")
+        return
+    if(_value_[0] != 0x01):
+        print("\n   SHA-256 Status -> Invalid Mode or Address Range ")
+        return
+    Digest = bytes(_value_[1:33])
+    SHA256_Digest = Digest
+    Cycles = struct.unpack('<I', bytes(_value_[33:37]))[0]
+    print("\n   SHA-256 : ", Digest.hex())
+    print("   Hashing Cycles : ", Cycles)
+    if(SHA256_Hashed_Length):
+        Cycles_Per_Byte = Cycles / SHA256_Hashed_Length
+        ''' one UART frame is 10 bits '''
+        UART_Cycles_Per_Byte = BL_CPU_CLOCK_HZ / (Serial_Port_Obj.baudrate / 10)
+        print("   Cycles/Byte : {0:.1f} (UART budget {1:.1f} cycles/byte)".format(Cycles_Per_Byte, UART_Cycles_Per_Byte))
+    if(os.path.exists("Application.bin") and (SHA256_Hashed_Length == CalulateBinFileLength())):
+        with open('Application.bin', 'rb') as Local_File:
+            Local_Digest = hashlib.sha256(Local_File.read()).digest()
+        if(Local_Digest == Digest):
+            print("   Application.bin SHA-256 -> Match ")
+        else:
+            print("   Application.bin SHA-256 -> Mismatch ")
+
+def Local_Sector_CRCs():
+    ''' CRC of every application sector as it should look after flashing Application.bin at APP_BASE_ADDRESS '''
+    Sector_CRCs = {}
+    if(not os.path.exists("Application.bin")):
+        return Sector_CRCs
+    with open('Application.bin', 'rb') as Local_File:
+        Image = Local_File.read()
+    Sector_Offset = 0
+    for Sector in range(APP_FIRST_SECTOR, len(FLASH_SECTOR_SIZES)):
+        Sector_Size = FLASH_SECTOR_SIZES[Sector]
+        Sector_Data = Image[Sector_Offset : Sector_Offset + Sector_Size]
+        ''' the rest of the sector stays erased '''
+        Sector_Data = Sector_Data + b'\xFF' * (Sector_Size - len(Sector_Data))
+        Sector_CRCs[Sector] = Calculate_CRC32_Words(Sector_Data)
+        Sector_Offset = Sector_Offset + Sector_Size
+    return Sector_CRCs
+
+def Process_CBL_SECTOR_MANIFEST_CMD(Data_Len):
+    global Manifest_Status
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    Manifest_Status = _value_[0]
+    if(_value_[0] != MANIFEST_REQUEST_VALID):
+        print("\n   Manifest Status -> Invalid Operation or Commit Failed ")
+        return
+    Generation = struct.unpack('<I', bytes(_value_[1:5]))[0]
+    Local_CRCs = Local_Sector_CRCs()
+    print("\n   Manifest Generation : ", Generation)
+    for Sector in range(APP_FIRST_SECTOR, len(FLASH_SECTOR_SIZES)):
+        Offset = 5 + (Sector - APP_FIRST_SECTOR) * 5
+        Sector_State = _value_[Offset]
+        Sector_CRC = struct.unpack('<I', bytes(_value_[Offset + 1 : Offset + 5]))[0]
+        if(Sector_State == MANIFEST_SECTOR_UNKNOWN):
+            State_Text = "Unknown "
+        elif(Sector_State == MANIFEST_SECTOR_MATCH):
+            State_Text = "Match   "
+        else:
+            State_Text = "Mismatch"
+        Diff_Text = ""
+        if((Sector in Local_CRCs) and (Sector_State != MANIFEST_SECTOR_UNKNOWN)):
+            Diff_Text = "Application.bin -> Same" if(Local_CRCs[Sector] == Sector_CRC) else "Application.bin -> Differs"
+        print("   Sector {0} : {1} CRC 0x{2:08x}  {3}".format(Sector, State_Text, Sector_CRC, Diff_Text))
+
+def Process_CBL_SLOT_INFO_CMD(Data_Len):
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] != 0x01):
+        print("\n   Slot Info Status -> Invalid Operation ")
+        return
+    Active_Slot = _value_[1]
+    if(Active_Slot == NO_SLOT):
+        print("\n   Active Slot : None (single image or no bootable slot)")
+    else:
+        print("\n   Active Slot : ", SLOT_NAMES[Active_Slot])
+    for Slot in range(len(SLOT_NAMES)):
+        Offset = 2 + Slot * 10
+        Slot_Valid = _value_[Offset]
+        Slot_Attempts = "Rejected" if(_value_[Offset + 1] == SLOT_REJECTED) else _value_[Offset + 1]
+        Fw_Version, Image_Size = struct.unpack('<II', bytes(_value_[Offset + 2 : Offset + 10]))
+        print("   Slot {0} @ 0x{1:08x} : {2} Version 0x{3:08x} Size {4} Boot Attempts {5}".format(
+            SLOT_NAMES[Slot], SLOT_BASE_ADDRESSES[Slot], "Valid  " if(Slot_Valid) else "Invalid",
+            Fw_Version, Image_Size, Slot_Attempts))
+    if(Active_Slot != NO_SLOT):
+        print("   Write the update to slot {0} (0x{1:08x})".format(SLOT_NAMES[Active_Slot ^ 1], SLOT_BASE_ADDRESSES[Active_Slot ^ 1]))
+
+def Cycles_To_Us(Cycles):
+    return (Cycles * 1000000.0) / BL_CPU_CLOCK_HZ
+
+def Process_CBL_GET_TIMING_CMD(Data_Len):
+    global Timing_Print_Boot
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] != 0x01):
+        print("\n   Timing Status -> Invalid Command Code ")
+        return
+    Words = struct.unpack('<%dI' % ((len(_value_) - 1) // 4), bytes(_value_[1:]))
+    Boot_Timestamps = Words[0:len(BOOT_TIMESTAMP_NAMES)]
+    Decision_Cycles = Words[len(BOOT_TIMESTAMP_NAMES)]
+    Command_Count = Words[len(BOOT_TIMESTAMP_NAMES) + 1]
+    Phases = Words[len(BOOT_TIMESTAMP_NAMES) + 2 : len(BOOT_TIMESTAMP_NAMES) + 2 + len(TIMING_PHASE_NAMES)]
+    Total = Words[len(BOOT_TIMESTAMP_NAMES) + 2 + len(TIMING_PHASE_NAMES)]
+    if(Timing_Print_Boot):
+        ''' cycles before SystemClock_Config run on the 16 MHz HSI '''
+        print("\n   Boot timestamps (CPU cycles since reset) :")
+        for Name, Cycles in zip(BOOT_TIMESTAMP_NAMES, Boot_Timestamps):
+            print("      {0:<18} : {1}".format(Name, Cycles))
+        print("      {0:<18} : {1}".format("Boot Decision", Decision_Cycles))
+        Timing_Print_Boot = 0
+    Phase_Text = " ".join("{0} {1:.1f}us".format(Name, Cycles_To_Us(Cycles)) for Name, Cycles in zip(TIMING_PHASE_NAMES, Phases))
+    print("   Dispatches {0:<5} Total {1:9.1f}us : {2}".format(Command_Count, Cycles_To_Us(Total), Phase_Text))
+
+def Process_CBL_EXEC_RAM_STUB_CMD(Data_Len):
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] != 0x01):
+        print("\n   RAM Stub Status -> Invalid Stub (address , header , stack or CRC) ")
+        return
+    Stub_Return = struct.unpack('<I', bytes(_value_[1:5]))[0]
+    print("\n   RAM Stub returned : 0x{0:08x}".format(Stub_Return))
+
+def Process_CBL_MEM_READ_CMD(Data_Len):
+    global Memory_Read_Data
+    Memory_Read_Data = None
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] == MEM_READ_RDP_ACTIVE):
+        print("\n   Memory Read Status -> Refused , read protection is active ")
+        return
+    if((_value_[0] != MEM_READ_PASSED) or (len(_value_) < 5)):
+        print("\n   Memory Read Status -> Invalid Address or Length ")
+        return
+    ''' the bootloader feeds status and data bytes to its CRC engine one word per byte '''
+    Reply_CRC = struct.unpack('<I', bytes(_value_[-4:]))[0]
+    if((Calculate_CRC32(list(_value_[:-4]), len(_value_) - 4) & 0xFFFFFFFF) != Reply_CRC):
+        print("\n   Memory Read Status -> Reply CRC mismatch ")
+        return
+    Memory_Read_Data = bytes(_value_[1:-4])
+
+def Process_CBL_MEM_DUMP_CMD(Data_Len):
+    global Dump_Reply
+    Dump_Reply = None
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] == MEM_READ_RDP_ACTIVE):
+        print("\n   Memory Dump Status -> Refused , read protection is active ")
+    elif(_value_[0] != MEM_READ_PASSED):
+        print("\n   Memory Dump Status -> Invalid Address , Length or Window ")
+    else:
+        ''' block size , window granted by the bootloader '''
+        Dump_Reply = (_value_[1] | (_value_[2] << 8), _value_[3])
+        print("\n   Memory Dump Started : Block Size {0} Window {1}".format(Dump_Reply[0], Dump_Reply[1]))
+
+def Process_CBL_BLANK_CHECK_CMD(Data_Len):
+    global Blank_Check_Result
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    ''' (status , offset of the first non blank byte) '''
+    Blank_Check_Result = (_value_[0], struct.unpack('<I', bytes(_value_[1:5]))[0])
+    if(_value_[0] == BLANK_CHECK_BLANK):
+        print("\n   Blank Check Status -> Range is erased ")
+    elif(_value_[0] == BLANK_CHECK_NOT_BLANK):
+        print("\n   Blank Check Status -> Not erased , first programmed byte at offset 0x{0:x} ".format(Blank_Check_Result[1]))
+    else:
+        print("\n   Blank Check Status -> Invalid Address or Length (flash only) ")
+
+def Process_CBL_BLOCK_DIFF_CMD(Data_Len):
+    global Block_Diff_Bitmap
+    Block_Diff_Bitmap = None
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytearray(Serial_Data)
+    if(_value_[0] == MEM_READ_RDP_ACTIVE):
+        print("\n   Block Diff Status -> Refused , read protection is active ")
+        return
+    if(_value_[0] != DIFF_PASSED):
+        print("\n   Block Diff Status -> Invalid base address or block outside the flash ")
+        return
+    Block_Diff_Bitmap = bytes(_value_[1:])
+
+def Process_CBL_GET_DEVICE_INFO_CMD(Data_Len):
+    global Device_Info
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytes(Serial_Data)
+    Chip_ID, RDP_Level = struct.unpack('<HB', _value_[4:7])
+    Flash_Size_KB, Max_Frame, Features = struct.unpack('<HHI', _value_[19:27])
+    Image_Valid, Active_Slot, Header_Present, Fw_Version, Image_Size, Image_CRC = struct.unpack('<BBBIII', _value_[27:42])
+    Number_Of_Baud_Rates = _value_[42]
+    Baud_Rates = list(struct.unpack('<%dI' % Number_Of_Baud_Rates, _value_[43 : 43 + 4 * Number_Of_Baud_Rates]))
+    Commands_Offset = 43 + 4 * Number_Of_Baud_Rates
+    Device_Info = {
+        'Vendor_ID'     : _value_[0],
+        'Version'       : (_value_[1], _value_[2], _value_[3]),
+        'Chip_ID'       : Chip_ID,
+        'RDP_Level'     : RDP_Level,
+        'UID'           : _value_[7:19].hex(),
+        'Flash_Size_KB' : Flash_Size_KB,
+        'Max_Frame'     : Max_Frame,
+        'Features'      : [Name for Bit, Name in enumerate(FEATURE_NAMES) if Features & (1 << Bit)],
+        'Image_Valid'   : Image_Valid,
+        'Active_Slot'   : Active_Slot,
+        'Image_Header'  : (Fw_Version, Image_Size, Image_CRC) if Header_Present else None,
+        'Baud_Rates'    : Baud_Rates,
+        'Commands'      : list(_value_[Commands_Offset + 1 : Commands_Offset + 1 + _value_[Commands_Offset]])}
+    print("\n   Bootloader Vendor ID : ", Device_Info['Vendor_ID'], " Version : {0}.{1}.{2}".format(*Device_Info['Version']))
+    print("   Chip ID : {0}  RDP : 0x{1:02x}  UID : {2}".format(hex(Chip_ID), RDP_Level, Device_Info['UID']))
+    print("   Flash : {0} KB  Max Frame : {1}  Baud Rates : {2}".format(Flash_Size_KB, Max_Frame, Baud_Rates))
+    print("   Features : ", ", ".join(Device_Info['Features']) or "None")
+    print("   Image : {0}".format("Valid" if Image_Valid else "Invalid"), end = ' ')
+    if(Active_Slot != NO_SLOT):
+        print(" Slot {0}".format(SLOT_NAMES[Active_Slot]), end = ' ')
+    if(Header_Present):
+        print(" Version 0x{0:08x} Size {1} CRC 0x{2:08x}".format(Fw_Version, Image_Size, Image_CRC), end = ' ')
+    print("\n   Supported Commands : ", " ".join(hex(Command) for Command in Device_Info['Commands']))
+
+def Process_CBL_SESSION_OPEN_CMD(Data_Len):
+    Serial_Data = Read_Serial_Port(Data_Len)
+    _value_ = bytes(Serial_Data)
+    if(_value_[0] != SESSION_OPENED):
+        print("\n   Session Status -> Refused ")
+        return
+    Frame_Size, Window, CRC_Mode, Compression, Baud_Rate = struct.unpack('<HBBBI', _value_[1:10])
+    Session.update({'Open' : 1, 'Frame_Size' : Frame_Size, 'Window' : Window, 'CRC_Mode' : CRC_Mode, 'Compression' : Compression})
+    if((Frame_Size, CRC_Mode, Compression, Baud_Rate) == (MAX_FRAME_SIZE, SESSION_CRC_BYTE, 0, DEFAULT_BAUD_RATE)):
+        ''' the defaults are back , nothing to confirm or to time out '''
+        Session['Open'] = 0
+    ''' the bootloader switched once the reply left , follow it '''
+    if(Serial_Port_Obj.baudrate != Baud_Rate):
+        Serial_Port_Obj.baudrate = Baud_Rate
+    print("\n   Session Opened : Frame {0} Window {1} CRC {2} Compression {3} Baud {4}".format(
+        Frame_Size, Window, "Word" if CRC_Mode == SESSION_CRC_WORD else "Byte", "On" if Compression else "Off", Baud_Rate))
+
+def Build_CRC32_Table():
+    CRC_Table = []
+    for Table_Index in range(256):
+        CRC_Value = Table_Index << 24
+        for DataElemBitLen in range(8):
+            if(CRC_Value & 0x80000000):
+                CRC_Value = ((CRC_Value << 1) ^ 0x04C11DB7) & 0xFFFFFFFF
+            else:
+                CRC_Value = (CRC_Value << 1) & 0xFFFFFFFF
+        CRC_Table.append(CRC_Value)
+    return CRC_Table
+
+CRC32_Table = Build_CRC32_Table()
+
+def Calculate_CRC32_Words(Data):
+    ''' Same result as the STM32 CRC engine fed with little endian 32-bit words '''
+    CRC_Value = 0xFFFFFFFF
+    Word_Count = len(Data) // 4
+    for Word in struct.unpack('<%dI' % Word_Count, Data[0 : Word_Count * 4]):
+        for Byte_Shift in (24, 16, 8, 0):
+            CRC_Value = ((CRC_Value << 8) & 0xFFFFFFFF) ^ CRC32_Table[((CRC_Value >> 24) ^ (Word >> Byte_Shift)) & 0xFF]
+    return CRC_Value
+
+def Calculate_CRC32_Bytes(Data):
+    ''' Same result as Calculate_CRC32 (one engine word per byte) using the table '''
+    CRC_Value = 0xFFFFFFFF
+    for Data_Byte in Data:
+        for Byte_Value in (0, 0, 0, Data_Byte):
+            CRC_Value = ((CRC_Value << 8) & 0xFFFFFFFF) ^ CRC32_Table[((CRC_Value >> 24) ^ Byte_Value) & 0xFF]
+    return CRC_Value
+
+def Calculate_Frame_CRC32(Buffer, Buffer_Length, CRC_Mode = None):
+    ''' Request frame CRC in the session CRC mode , the session open frame always uses the byte CRC '''
+    if(CRC_Mode is None):
+        CRC_Mode = Session['CRC_Mode']
+    if((CRC_Mode == SESSION_CRC_WORD) and (Buffer[1] != CBL_SESSION_OPEN_CMD)):
+        Frame = bytes(Buffer[0:Buffer_Length])
+        return Calculate_CRC32_Words(Frame + b'\x00' * ((4 - (Buffer_Length % 4)) % 4))
+    return Calculate_CRC32(Buffer, Buffer_Length) & 0xFFFFFFFF
+
+def Pack_Bits(Data):
+    ''' PackBits , runs of 3 or more equal bytes become (257 - length , byte) '''
+    Packed = bytearray()
+    Literal = bytearray()
+    Index = 0
+    while(Index < len(Data)):
+        Run_Length = 1
+        while((Index + Run_Length < len(Data)) and (Run_Length < 128) and (Data[Index + Run_Length] == Data[Index])):
+            Run_Length += 1
+        if(Run_Length >= 3):
+            if(Literal):
+                Packed += bytes([len(Literal) - 1]) + Literal
+                Literal = bytearray()
+            Packed += bytes([257 - Run_Length, Data[Index]])
+            Index += Run_Length
+        else:
+            Literal.append(Data[Index])
+            Index += 1
+            if(len(Literal) == 128):
+                Packed += bytes([127]) + Literal
+                Literal = bytearray()
+    if(Literal):
+        Packed += bytes([len(Literal) - 1]) + Literal
+    return bytes(Packed)
+
 def Calculate_CRC32(Buffer, Buffer_Length):
     CRC_Value = 0xFFFFFFFF
     for DataElem in Buffer[0:Buffer_Length]:
@@ -208,6 +869,239 @@ def Calculate_CRC32(Buffer, Buffer_Length):
                 CRC_Value = (CRC_Value << 1)
     return CRC_Value
     
+def Strip_Image_Header(Image):
+    if((len(Image) >= IMAGE_HEADER_SIZE) and (struct.unpack('<I', Image[0:4])[0] == IMAGE_HEADER_MAGIC)):
+        return Image[IMAGE_HEADER_SIZE:]
+    return Image
+
+def Build_Image_Header(Image, Load_Address, Fw_Version):
+    ''' Image is padded to whole words , the bootloader CRC engine works on words '''
+    Image = Image + b'\xFF' * ((4 - (len(Image) % 4)) % 4)
+    Entry_Point = struct.unpack('<I', Image[4:8])[0]
+    Header_Fields = struct.pack('<7I', IMAGE_HEADER_MAGIC, IMAGE_HEADER_VERSION, Fw_Version, len(Image),
+                                Load_Address, Entry_Point, Calculate_CRC32_Words(Image))
+    Header = Header_Fields + struct.pack('<I', Calculate_CRC32_Words(Header_Fields))
+    return Header + b'\xFF' * (IMAGE_HEADER_SIZE - len(Header)), Image
+
+def Stamp_Image_Header(Header_Address, Fw_Version):
+    with open('Application.bin', 'rb') as Local_File:
+        Image = Strip_Image_Header(Local_File.read())
+    Load_Address = Header_Address + IMAGE_HEADER_SIZE
+    Header, Image = Build_Image_Header(Image, Load_Address, Fw_Version)
+    Entry_Point = struct.unpack('<I', Image[4:8])[0]
+    if(not (Load_Address <= (Entry_Point & ~1) < (Load_Address + len(Image)))):
+        print("\n   Warning !! entry point 0x{0:08x} is outside the image , is it linked at 0x{1:08x} ?".format(Entry_Point, Load_Address))
+    with open('Application.bin', 'wb') as Local_File:
+        Local_File.write(Header + Image)
+    print("\n   Application.bin stamped : Version 0x{0:08x} Size {1} Load 0x{2:08x} Entry 0x{3:08x}".format(
+        Fw_Version, len(Image), Load_Address, Entry_Point))
+    print("   Write it at 0x{0:08x}".format(Header_Address))
+
+def Prepare_Stub_Image(Stub):
+    ''' The stub author fills magic , API version , entry and stack top , size and CRC are patched here '''
+    Stub = Stub + b'\x00' * ((4 - (len(Stub) % 4)) % 4)
+    Magic, Api_Version, Size, Entry, Stack_Top, Stub_CRC = struct.unpack('<6I', Stub[0:STUB_HEADER_SIZE])
+    if((Magic != STUB_MAGIC) or (Api_Version != STUB_API_VERSION)):
+        return None
+    return struct.pack('<6I', Magic, Api_Version, len(Stub), Entry, Stack_Top,
+                       Calculate_CRC32_Words(Stub[STUB_HEADER_SIZE:])) + Stub[STUB_HEADER_SIZE:]
+
+def Build_Memory_Write_Frames(Base_Address, Data, Link_Session):
+    ''' CBL_MEM_WRITE_CMD packets of 128 bytes , or as large as the session frame allows '''
+    Start_Time = monotonic()
+    Frames = []
+    Max_Payload = (Link_Session['Frame_Size'] - 11) if Link_Session['Open'] else 128
+    Offset = 0
+    while(Offset < len(Data)):
+        Payload = Data[Offset : Offset + Max_Payload]
+        Frame_Payload = Payload
+        if(Link_Session['Compression']):
+            ''' a frame shorter than its payload length tells the bootloader the payload is packed '''
+            Packed = Pack_Bits(Data[Offset : Offset + 255])
+            if((len(Packed) <= Max_Payload) and (len(Packed) < len(Data[Offset : Offset + 255]))):
+                Payload = Data[Offset : Offset + 255]
+                Frame_Payload = Packed
+        Address = Base_Address + Offset
+        Offset += len(Payload)
+        CBL_MEM_WRITE_CMD_Len = len(Frame_Payload) + 11
+        BL_Host_Buffer = [CBL_MEM_WRITE_CMD_Len - 1, CBL_MEM_WRITE_CMD]
+        BL_Host_Buffer += [Word_Value_To_Byte_Value(Address, Byte_Index, 1) for Byte_Index in range(1, 5)]
+        BL_Host_Buffer += [len(Payload)] + list(Frame_Payload)
+        CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_MEM_WRITE_CMD_Len - 4, Link_Session['CRC_Mode']) & 0xFFFFFFFF
+        BL_Host_Buffer += [Word_Value_To_Byte_Value(CRC32_Value, Byte_Index, 1) for Byte_Index in range(1, 5)]
+        Frames.append(bytes(BL_Host_Buffer[0 : CBL_MEM_WRITE_CMD_Len]))
+    Link_Metrics['Build_Time'] += monotonic() - Start_Time
+    return Frames
+
+def Send_Memory_Write_Frames(Frames, Progress = None):
+    global Memory_Write_All
+    Memory_Write_All = 1
+    Start_Time = monotonic()
+    for Frame_Index, Frame in enumerate(Frames, 1):
+        if(not Send_Command_Frame(Frame, CBL_MEM_WRITE_CMD)):
+            break
+        ''' the length byte counts the unpacked payload '''
+        Link_Metrics['Payload_Bytes'] += Frame[6]
+        if(Progress is not None):
+            Progress['next_address'] = struct.unpack_from('<I', Frame, 2)[0] + Frame[6]
+            Progress['bytes_acknowledged'] += Frame[6]
+            if((Frame_Index % PROGRESS_SAVE_FRAMES) == 0):
+                Save_Transfer_Progress(Progress)
+    Link_Metrics['Payload_Time'] += monotonic() - Start_Time
+    if((Progress is not None) and (Memory_Write_All != 1)):
+        Save_Transfer_Progress(Progress)
+    return Memory_Write_All
+
+def Write_Memory_Block(Base_Address, Data):
+    return Send_Memory_Write_Frames(Build_Memory_Write_Frames(Base_Address, Data, Session))
+
+def Build_Image_Frames(Segments, Link_Session):
+    Frames = []
+    for Address, Data in Segments:
+        Frames += Build_Memory_Write_Frames(Address, Data, Link_Session)
+    return Frames
+
+def Read_Memory_Block(Base_Address, Length):
+    ''' CBL_MEM_READ_CMD requests of up to MEM_READ_MAX_LENGTH bytes , None when any chunk fails '''
+    Data = b''
+    for Offset in range(0, Length, MEM_READ_MAX_LENGTH):
+        Send_CBL_MEM_READ_CMD(Base_Address + Offset, min(MEM_READ_MAX_LENGTH, Length - Offset))
+        if(Memory_Read_Data is None):
+            return None
+        Data += Memory_Read_Data
+    return Data
+
+def Send_Dump_Control(Control_Type, Block_Index):
+    ''' sent as one write , the bootloader keeps streaming while it arrives '''
+    Control_Frame = bytes([Control_Type, Block_Index & 0xFF, (Block_Index >> 8) & 0xFF])
+    Write_Packet_To_Serial_Port(Control_Frame + struct.pack('<I', Calculate_CRC32_Bytes(Control_Frame)))
+
+def Dump_Memory(Base_Address, Length, Window):
+    ''' CBL_MEM_DUMP_CMD stream , cumulative ACK per block , None when the dump failed '''
+    Send_CBL_MEM_DUMP_CMD(Base_Address, Length, Window)
+    if(Dump_Reply is None):
+        return None
+    Block_Size = Dump_Reply[0]
+    Number_Of_Blocks = (Length + Block_Size - 1) // Block_Size
+    Blocks = {}
+    Expected_Block = 0
+    Requested_Block = None
+    Retries = 0
+    Serial_Port_Obj.timeout = DUMP_BLOCK_TIMEOUT
+    while(Expected_Block < Number_Of_Blocks):
+        Header = Serial_Port_Obj.read(2)
+        Block_Index = Header[0] | (Header[1] << 8) if(len(Header) == 2) else Number_Of_Blocks
+        if(Block_Index < Number_Of_Blocks):
+            Block_Len = min(Block_Size, Length - (Block_Index * Block_Size))
+            Body = Serial_Port_Obj.read(Block_Len + 4)
+            if((len(Body) == (Block_Len + 4)) and
+               (Calculate_CRC32_Bytes(Header + Body[:Block_Len]) == struct.unpack('<I', Body[Block_Len:])[0])):
+                Blocks[Block_Index] = Body[:Block_Len]
+                Retries = 0
+                if(Block_Index > Expected_Block):
+                    ''' a block went missing , ask for it once '''
+                    if(Requested_Block != Expected_Block):
+                        Send_Dump_Control(DUMP_CTRL_RETRANSMIT, Expected_Block)
+                        Requested_Block = Expected_Block
+                else:
+                    while(Expected_Block in Blocks):
+                        Expected_Block += 1
+                    Send_Dump_Control(DUMP_CTRL_ACK, Expected_Block)
+                continue
+        ''' timeout , bad index or CRC : wait for the line to go quiet then ask for the first missing block '''
+        Retries += 1
+        if(Retries > DUMP_MAX_RETRIES):
+            Send_Dump_Control(DUMP_CTRL_ABORT, 0)
+            print("\n   Error !! memory dump aborted at block", Expected_Block)
+            return None
+        while(len(Serial_Port_Obj.read(Block_Size))):
+            pass
+        Send_Dump_Control(DUMP_CTRL_RETRANSMIT, Expected_Block)
+        Requested_Block = Expected_Block
+    return b''.join(Blocks[Block_Index] for Block_Index in range(Number_Of_Blocks))
+
+def Flash_Sector_Of(Address):
+    Sector_Base = FLASH_BASE_ADDRESS
+    for Sector, Sector_Size in enumerate(FLASH_SECTOR_SIZES):
+        if(Sector_Base <= Address < Sector_Base + Sector_Size):
+            return Sector
+        Sector_Base += Sector_Size
+    return None
+
+def Plan_Erase_Sectors(Segments):
+    ''' the fewest sectors holding every flash segment , None when a segment reaches the bootloader or leaves the flash '''
+    Sectors = set()
+    for Address, Data in Segments:
+        First_Sector = Flash_Sector_Of(Address)
+        Last_Sector = Flash_Sector_Of(Address + len(Data) - 1)
+        if((First_Sector is None) and (Last_Sector is None)):
+            ''' SRAM , nothing to erase '''
+            continue
+        if((First_Sector is None) or (Last_Sector is None) or (First_Sector < APP_FIRST_SECTOR)):
+            return None
+        Sectors.update(range(First_Sector, Last_Sector + 1))
+    return sorted(Sectors)
+
+def Erase_Time_Estimate(Sectors):
+    return round(sum(FLASH_SECTOR_ERASE_TIMES[Sector] for Sector in Sectors), 2)
+
+def Erase_Flash_Sectors(Sectors):
+    ''' one CBL_FLASH_ERASE_CMD per run of consecutive sectors , 1 when every erase passed '''
+    Sectors = sorted(Sectors)
+    while(Sectors):
+        Run_Length = 1
+        while((Run_Length < len(Sectors)) and (Sectors[Run_Length] == Sectors[0] + Run_Length)):
+            Run_Length += 1
+        Send_CBL_FLASH_ERASE_CMD(Sectors[0], Run_Length)
+        if(Flash_Erase_Status != SUCCESSFUL_ERASE):
+            return 0
+        Sectors = Sectors[Run_Length:]
+    return 1
+
+def Diff_Flash_Image(Base_Address, Image):
+    ''' Indexes of the DIFF_BLOCK_SIZE blocks of Image that differ from the flash , None when the device refused '''
+    Number_Of_Blocks = (len(Image) + DIFF_BLOCK_SIZE - 1) // DIFF_BLOCK_SIZE
+    Changed_Blocks = []
+    for First_Block in range(0, Number_Of_Blocks, DIFF_MAX_PAIRS):
+        Pairs = []
+        for Block_Index in range(First_Block, min(First_Block + DIFF_MAX_PAIRS, Number_Of_Blocks)):
+            Block = Image[Block_Index * DIFF_BLOCK_SIZE : (Block_Index + 1) * DIFF_BLOCK_SIZE]
+            ''' the flash after the image stays erased '''
+            Block = Block + b'\xFF' * (DIFF_BLOCK_SIZE - len(Block))
+            Pairs.append((Block_Index, Calculate_CRC32_Words(Block)))
+        Send_CBL_BLOCK_DIFF_CMD(Base_Address, Pairs)
+        if(Block_Diff_Bitmap is None):
+            return None
+        for Pair_Index, (Block_Index, Block_CRC) in enumerate(Pairs):
+            if(Block_Diff_Bitmap[Pair_Index >> 3] & (1 << (Pair_Index & 7))):
+                Changed_Blocks.append(Block_Index)
+    return Changed_Blocks
+
+def Flash_Changed_Blocks(Base_Address, Image):
+    ''' Writes only the blocks that differ , erasing a sector only when a changed block there is not blank '''
+    Changed_Blocks = Diff_Flash_Image(Base_Address, Image)
+    if(Changed_Blocks is None):
+        return 0
+    print("\n   {0} of {1} blocks differ".format(len(Changed_Blocks), (len(Image) + DIFF_BLOCK_SIZE - 1) // DIFF_BLOCK_SIZE))
+    Erase_Sectors = set()
+    for Block_Index in Changed_Blocks:
+        Block_Address = Base_Address + Block_Index * DIFF_BLOCK_SIZE
+        Send_CBL_BLANK_CHECK_CMD(Block_Address, min(DIFF_BLOCK_SIZE, len(Image) - Block_Index * DIFF_BLOCK_SIZE))
+        if((Blank_Check_Result is None) or (Blank_Check_Result[0] != BLANK_CHECK_BLANK)):
+            Erase_Sectors.add(Flash_Sector_Of(Block_Address))
+    if(any((Sector is None) or (Sector < APP_FIRST_SECTOR) for Sector in Erase_Sectors)):
+        print("\n   Error !! the image overlaps the bootloader sectors")
+        return 0
+    if(Erase_Flash_Sectors(Erase_Sectors) == 0):
+        return 0
+    ''' an erased sector loses the unchanged blocks too '''
+    for Block_Index in range((len(Image) + DIFF_BLOCK_SIZE - 1) // DIFF_BLOCK_SIZE):
+        Block_Address = Base_Address + Block_Index * DIFF_BLOCK_SIZE
+        if((Block_Index in Changed_Blocks) or (Flash_Sector_Of(Block_Address) in Erase_Sectors)):
+            if(Write_Memory_Block(Block_Address, Image[Block_Index * DIFF_BLOCK_SIZE : (Block_Index + 1) * DIFF_BLOCK_SIZE]) == 0):
+                return 0
+    return 1
+
 def Word_Value_To_Byte_Value(Word_Value, Byte_Index, Byte_Lower_First):
     Byte_Value = (Word_Value >> (8 * (Byte_Index - 1)) & 0x000000FF)
     return Byte_Value
@@ -216,9 +1110,434 @@ def CalulateBinFileLength():
     BinFileLength = os.path.getsize("Application.bin")
     return BinFileLength
 
-def OpenBinFile():
-    global BinFile
-    BinFile = open('Application.bin', 'rb')
+def Is_Located_Image(File_Name):
+    ''' ELF and Intel HEX carry their addresses , a raw binary needs a base address '''
+    return os.path.splitext(File_Name)[1].lower() in ('.elf', '.axf', '.hex', '.ihex')
+
+def Parse_Intel_Hex_Segments(Text):
+    Segments = []
+    Upper_Address = 0
+    for Line_Number, Line in enumerate(Text.splitlines(), 1):
+        Line = Line.strip()
+        if(not Line):
+            continue
+        if(Line[0] != ':'):
+            raise ValueError("Intel HEX line {0} does not start with ':'".format(Line_Number))
+        Record = bytes.fromhex(Line[1:])
+        if((len(Record) < 5) or (len(Record) != Record[0] + 5) or (sum(Record) & 0xFF)):
+            raise ValueError("Intel HEX line {0} has a bad length or checksum".format(Line_Number))
+        Record_Type = Record[3]
+        Record_Data = Record[4:-1]
+        if(Record_Type == 0x00):
+            Segments.append((Upper_Address + ((Record[1] << 8) | Record[2]), Record_Data))
+        elif(Record_Type == 0x01):
+            break
+        elif(Record_Type == 0x02):
+            Upper_Address = ((Record_Data[0] << 8) | Record_Data[1]) << 4
+        elif(Record_Type == 0x04):
+            Upper_Address = ((Record_Data[0] << 8) | Record_Data[1]) << 16
+        ''' 0x03 and 0x05 carry the start address , the vector table already does '''
+    return Segments
+
+def Parse_ELF_Segments(Content):
+    ''' PT_LOAD program headers at their load address , so .data comes from its copy in flash '''
+    if((Content[4] != 1) or (Content[5] != 1)):
+        raise ValueError("only 32 bit little endian ELF files are supported")
+    Header_Offset = struct.unpack_from('<I', Content, 28)[0]
+    Header_Size, Header_Count = struct.unpack_from('<HH', Content, 42)
+    Segments = []
+    for Header_Index in range(Header_Count):
+        Segment_Type, File_Offset, Virtual_Address, Load_Address, File_Size = struct.unpack_from(
+            '<5I', Content, Header_Offset + Header_Index * Header_Size)
+        if((Segment_Type == 1) and File_Size):
+            Segments.append((Load_Address, Content[File_Offset : File_Offset + File_Size]))
+    return Segments
+
+def Load_Image_Segments(File_Name, Base_Address):
+    ''' [(Address , Data)] sorted with touching records merged , a raw binary is one segment at Base_Address '''
+    with open(File_Name, 'rb') as Image_File:
+        Content = Image_File.read()
+    if(Content[:4] == b'\x7fELF'):
+        Segments = Parse_ELF_Segments(Content)
+    elif(Is_Located_Image(File_Name)):
+        Segments = Parse_Intel_Hex_Segments(Content.decode('ascii'))
+    else:
+        Segments = [(Base_Address, Content)]
+    Merged = []
+    for Address, Data in sorted(Segments, key = lambda Segment: Segment[0]):
+        if(Merged and (Address < Merged[-1][0] + len(Merged[-1][1]))):
+            raise ValueError("image segments overlap at 0x{0:08x}".format(Address))
+        if(Merged and (Address == Merged[-1][0] + len(Merged[-1][1]))):
+            Merged[-1] = (Merged[-1][0], Merged[-1][1] + bytes(Data))
+        elif(len(Data)):
+            Merged.append((Address, bytes(Data)))
+    if(not Merged):
+        raise ValueError("the image holds no data")
+    return Merged
+
+def Sparse_Segments(Segments):
+    ''' cuts flash segments around word aligned 0xFF runs , SRAM segments are sent whole .
+        Only for ranges just erased , elsewhere the skipped runs would keep the old flash contents '''
+    Sparse = []
+    for Address, Data in Segments:
+        if((Flash_Sector_Of(Address) is None) or (Flash_Sector_Of(Address + len(Data) - 1) is None)):
+            Sparse.append((Address, Data))
+            continue
+        Start = 0
+        for Run in re.finditer(b'\xff{%d,}' % SPARSE_MIN_ERASED_RUN, Data):
+            ''' keep the pieces word aligned , the bootloader programs whole words there '''
+            Run_Start = Run.start() if(Run.start() == 0) else (((Address + Run.start() + 3) & ~3) - Address)
+            Run_End = Run.end() if(Run.end() == len(Data)) else (((Address + Run.end()) & ~3) - Address)
+            if(Run_Start > Start):
+                Sparse.append((Address + Start, Data[Start : Run_Start]))
+            Start = max(Start, Run_End)
+        if(Start < len(Data)):
+            Sparse.append((Address + Start, Data[Start:]))
+    return Sparse
+
+def Flatten_Segments(Segments):
+    ''' one image from the first to the last segment , gaps read as erased flash '''
+    Base_Address = Segments[0][0]
+    Image = bytearray(b'\xFF' * (Segments[-1][0] + len(Segments[-1][1]) - Base_Address))
+    for Address, Data in Segments:
+        Image[Address - Base_Address : Address - Base_Address + len(Data)] = Data
+    return Base_Address, bytes(Image)
+
+def Send_CBL_SECTOR_MANIFEST_CMD(Manifest_Op, Sector_Mask):
+    BL_Host_Buffer = [0] * 8
+    CBL_SECTOR_MANIFEST_CMD_Len = 8
+    BL_Host_Buffer[0] = CBL_SECTOR_MANIFEST_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_SECTOR_MANIFEST_CMD
+    BL_Host_Buffer[2] = Manifest_Op
+    BL_Host_Buffer[3] = Sector_Mask
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_SECTOR_MANIFEST_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_SECTOR_MANIFEST_CMD_Len], CBL_SECTOR_MANIFEST_CMD)
+
+def Send_CBL_SLOT_INFO_CMD(Slot_Op):
+    BL_Host_Buffer = [0] * 7
+    CBL_SLOT_INFO_CMD_Len = 7
+    BL_Host_Buffer[0] = CBL_SLOT_INFO_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_SLOT_INFO_CMD
+    BL_Host_Buffer[2] = Slot_Op
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_SLOT_INFO_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_SLOT_INFO_CMD_Len], CBL_SLOT_INFO_CMD)
+
+def Send_CBL_GET_TIMING_CMD(Command_Code):
+    BL_Host_Buffer = [0] * 7
+    CBL_GET_TIMING_CMD_Len = 7
+    BL_Host_Buffer[0] = CBL_GET_TIMING_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_GET_TIMING_CMD
+    BL_Host_Buffer[2] = Command_Code
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_TIMING_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_TIMING_CMD_Len], CBL_GET_TIMING_CMD)
+
+def Send_CBL_EXEC_RAM_STUB_CMD(Stub_Address, Stub_Arg):
+    BL_Host_Buffer = [0] * 14
+    CBL_EXEC_RAM_STUB_CMD_Len = 14
+    BL_Host_Buffer[0] = CBL_EXEC_RAM_STUB_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_EXEC_RAM_STUB_CMD
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(Stub_Address, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(Stub_Address, 2, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(Stub_Address, 3, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(Stub_Address, 4, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(Stub_Arg, 1, 1)
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(Stub_Arg, 2, 1)
+    BL_Host_Buffer[8] = Word_Value_To_Byte_Value(Stub_Arg, 3, 1)
+    BL_Host_Buffer[9] = Word_Value_To_Byte_Value(Stub_Arg, 4, 1)
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_EXEC_RAM_STUB_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[10] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[11] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[12] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[13] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_EXEC_RAM_STUB_CMD_Len], CBL_EXEC_RAM_STUB_CMD)
+
+def Send_CBL_MEM_READ_CMD(Read_Address, Read_Length):
+    BL_Host_Buffer = [0] * 11
+    CBL_MEM_READ_CMD_Len = 11
+    BL_Host_Buffer[0] = CBL_MEM_READ_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_MEM_READ_CMD
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(Read_Address, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(Read_Address, 2, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(Read_Address, 3, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(Read_Address, 4, 1)
+    BL_Host_Buffer[6] = Read_Length
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_MEM_READ_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[8] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[9] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[10] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_MEM_READ_CMD_Len], CBL_MEM_READ_CMD)
+
+def Send_CBL_MEM_DUMP_CMD(Dump_Address, Dump_Length, Dump_Window):
+    BL_Host_Buffer = [0] * 15
+    CBL_MEM_DUMP_CMD_Len = 15
+    BL_Host_Buffer[0] = CBL_MEM_DUMP_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_MEM_DUMP_CMD
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(Dump_Address, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(Dump_Address, 2, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(Dump_Address, 3, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(Dump_Address, 4, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(Dump_Length, 1, 1)
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(Dump_Length, 2, 1)
+    BL_Host_Buffer[8] = Word_Value_To_Byte_Value(Dump_Length, 3, 1)
+    BL_Host_Buffer[9] = Word_Value_To_Byte_Value(Dump_Length, 4, 1)
+    BL_Host_Buffer[10] = Dump_Window
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_MEM_DUMP_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[11] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[12] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[13] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[14] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_MEM_DUMP_CMD_Len], CBL_MEM_DUMP_CMD)
+
+def Send_CBL_BLANK_CHECK_CMD(Check_Address, Check_Length):
+    BL_Host_Buffer = [0] * 14
+    CBL_BLANK_CHECK_CMD_Len = 14
+    BL_Host_Buffer[0] = CBL_BLANK_CHECK_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_BLANK_CHECK_CMD
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(Check_Address, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(Check_Address, 2, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(Check_Address, 3, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(Check_Address, 4, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(Check_Length, 1, 1)
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(Check_Length, 2, 1)
+    BL_Host_Buffer[8] = Word_Value_To_Byte_Value(Check_Length, 3, 1)
+    BL_Host_Buffer[9] = Word_Value_To_Byte_Value(Check_Length, 4, 1)
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_BLANK_CHECK_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[10] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[11] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[12] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[13] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_BLANK_CHECK_CMD_Len], CBL_BLANK_CHECK_CMD)
+
+def Send_CBL_FLASH_ERASE_CMD(Sector_Number, Number_Of_Sectors):
+    BL_Host_Buffer = [0] * 8
+    CBL_FLASH_ERASE_CMD_Len = 8
+    BL_Host_Buffer[0] = CBL_FLASH_ERASE_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_FLASH_ERASE_CMD
+    BL_Host_Buffer[2] = Sector_Number
+    BL_Host_Buffer[3] = Number_Of_Sectors
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_FLASH_ERASE_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_FLASH_ERASE_CMD_Len], CBL_FLASH_ERASE_CMD)
+
+def Send_CBL_BLOCK_DIFF_CMD(Base_Address, Pairs):
+    CBL_BLOCK_DIFF_CMD_Len = 11 + len(Pairs) * 6
+    BL_Host_Buffer = [CBL_BLOCK_DIFF_CMD_Len - 1, CBL_BLOCK_DIFF_CMD]
+    BL_Host_Buffer += [Word_Value_To_Byte_Value(Base_Address, Byte_Index, 1) for Byte_Index in range(1, 5)]
+    BL_Host_Buffer += [len(Pairs)]
+    for Block_Index, Block_CRC in Pairs:
+        BL_Host_Buffer += [Word_Value_To_Byte_Value(Block_Index, 1, 1), Word_Value_To_Byte_Value(Block_Index, 2, 1)]
+        BL_Host_Buffer += [Word_Value_To_Byte_Value(Block_CRC, Byte_Index, 1) for Byte_Index in range(1, 5)]
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_BLOCK_DIFF_CMD_Len - 4) & 0xFFFFFFFF
+    BL_Host_Buffer += [Word_Value_To_Byte_Value(CRC32_Value, Byte_Index, 1) for Byte_Index in range(1, 5)]
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_BLOCK_DIFF_CMD_Len], CBL_BLOCK_DIFF_CMD)
+
+def Send_CBL_GET_DEVICE_INFO_CMD():
+    BL_Host_Buffer = [0] * 6
+    CBL_GET_DEVICE_INFO_CMD_Len = 6
+    BL_Host_Buffer[0] = CBL_GET_DEVICE_INFO_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_GET_DEVICE_INFO_CMD
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_DEVICE_INFO_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_DEVICE_INFO_CMD_Len], CBL_GET_DEVICE_INFO_CMD)
+
+def Send_CBL_SESSION_OPEN_CMD(Frame_Size, Window, CRC_Mode, Compression, Baud_Rate):
+    BL_Host_Buffer = [0] * 15
+    CBL_SESSION_OPEN_CMD_Len = 15
+    BL_Host_Buffer[0] = CBL_SESSION_OPEN_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_SESSION_OPEN_CMD
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(Frame_Size, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(Frame_Size, 2, 1)
+    BL_Host_Buffer[4] = Window
+    BL_Host_Buffer[5] = CRC_Mode
+    BL_Host_Buffer[6] = Compression
+    BL_Host_Buffer[7] = Word_Value_To_Byte_Value(Baud_Rate, 1, 1)
+    BL_Host_Buffer[8] = Word_Value_To_Byte_Value(Baud_Rate, 2, 1)
+    BL_Host_Buffer[9] = Word_Value_To_Byte_Value(Baud_Rate, 3, 1)
+    BL_Host_Buffer[10] = Word_Value_To_Byte_Value(Baud_Rate, 4, 1)
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_SESSION_OPEN_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[11] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[12] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[13] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[14] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    if(Send_Command_Frame(BL_Host_Buffer[0 : CBL_SESSION_OPEN_CMD_Len], CBL_SESSION_OPEN_CMD) and Session['Open']):
+        Confirm_Session()
+
+def Confirm_Session():
+    ''' one frame in the new session before it is used , the bootloader closes the session on the first failed frame '''
+    BL_Host_Buffer = [0] * 6
+    CBL_GET_VER_CMD_Len = 6
+    BL_Host_Buffer[0] = CBL_GET_VER_CMD_Len - 1
+    BL_Host_Buffer[1] = CBL_GET_VER_CMD
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_VER_CMD_Len - 4)
+    CRC32_Value = CRC32_Value & 0xFFFFFFFF
+    BL_Host_Buffer[2] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
+    BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
+    BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
+    BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
+    Write_Packet_To_Serial_Port(BL_Host_Buffer[0 : CBL_GET_VER_CMD_Len])
+    try:
+        Read_Data_From_Serial_Port(CBL_GET_VER_CMD)
+        return 1
+    except BL_Response_Error as Response_Error:
+        print("\n   Error !! the session did not answer ,", Response_Error)
+    ''' whatever the bootloader made of the frame , it is back to the defaults once its idle timeout ran out '''
+    sleep(SESSION_IDLE_TIMEOUT + SESSION_IDLE_MARGIN)
+    Reset_Session()
+    return 0
+
+def Reset_Session():
+    ''' the protocol of a bootloader that never opened a session , at the rate of MX_USART2_UART_Init '''
+    Session.update(DEFAULT_SESSION)
+    if(Serial_Port_Obj.baudrate != DEFAULT_BAUD_RATE):
+        Serial_Port_Obj.baudrate = DEFAULT_BAUD_RATE
+    Serial_Port_Obj.reset_input_buffer()
+
+def Close_Session():
+    ''' back to the defaults before the port is released , the next tool starts at DEFAULT_BAUD_RATE '''
+    Send_CBL_SESSION_OPEN_CMD(MAX_FRAME_SIZE, DUMP_MAX_WINDOW, SESSION_CRC_BYTE, 0, DEFAULT_BAUD_RATE)
+    if(Session['Open'] or (Serial_Port_Obj.baudrate != DEFAULT_BAUD_RATE)):
+        ''' no answer , the bootloader idle timeout closes it instead '''
+        Reset_Session()
+
+def Expire_Idle_Session():
+    ''' the bootloader closed a session idle for BL_SESSION_IDLE_TIMEOUT_MS , follow it before the next frame is built '''
+    if(not Session['Open']):
+        return
+    Idle_Time = monotonic() - Link_Last_Activity
+    if(Idle_Time < (SESSION_IDLE_TIMEOUT - SESSION_IDLE_MARGIN)):
+        return
+    ''' too close to the timeout to know which side the bootloader is on , wait until it closed for sure '''
+    sleep(max(0, SESSION_IDLE_TIMEOUT + SESSION_IDLE_MARGIN - Idle_Time))
+    print("\n   Session idle for more than {0} s , the bootloader is back to the default session".format(SESSION_IDLE_TIMEOUT))
+    Reset_Session()
+
+def Send_CBL_GET_SHA256_CMD(SHA256_Mode, Region_Address, Region_Length):
+    global SHA256_Hashed_Length
+    SHA256_Hashed_Length = Region_Length
+    CBL_GET_SHA256_CMD_Len = 15
+    BL_Host_Buffer = [CBL_GET_SHA256_CMD_Len - 1, CBL_GET_SHA256_CMD, SHA256_Mode]
+    BL_Host_Buffer += [Word_Value_To_Byte_Value(Region_Address, Byte_Index, 1) for Byte_Index in range(1, 5)]
+    BL_Host_Buffer += [Word_Value_To_Byte_Value(Region_Length, Byte_Index, 1) for Byte_Index in range(1, 5)]
+    CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_SHA256_CMD_Len - 4) & 0xFFFFFFFF
+    BL_Host_Buffer += [Word_Value_To_Byte_Value(CRC32_Value, Byte_Index, 1) for Byte_Index in range(1, 5)]
+    Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_SHA256_CMD_Len], CBL_GET_SHA256_CMD)
+
+def Progress_File_Name(Image_File_Name, Port):
+    ''' one progress file per image and port , boards of a gang run resume on their own '''
+    return "{0}.{1}{2}".format(Image_File_Name, re.sub(r'\W', '_', Port).strip('_'), PROGRESS_FILE_SUFFIX)
+
+def Image_Digest(Segments):
+    Digest = hashlib.sha256()
+    for Address, Data in Segments:
+        Digest.update(struct.pack('<II', Address, len(Data)))
+        Digest.update(Data)
+    return Digest.hexdigest()
+
+def Open_Transfer_Progress(Progress_File, Segments):
+    ''' the saved progress when it belongs to this very image , a fresh one otherwise '''
+    Progress = {'file' : Progress_File, 'image_sha256' : Image_Digest(Segments), 'next_address' : None, 'bytes_acknowledged' : 0}
+    try:
+        with open(Progress_File) as Saved_File:
+            Saved = json.load(Saved_File)
+    except (OSError, ValueError):
+        Saved = {}
+    Progress['saved'] = (Saved.get('image_sha256') == Progress['image_sha256'])
+    if(Progress['saved']):
+        Progress['next_address'] = Saved.get('next_address')
+        Progress['bytes_acknowledged'] = Saved.get('bytes_acknowledged', 0)
+    return Progress
+
+def Save_Transfer_Progress(Progress):
+    ''' written aside then renamed , a host crash never leaves half a file '''
+    with open(Progress['file'] + '.tmp', 'w') as Progress_File:
+        json.dump({Key : Progress[Key] for Key in ('image_sha256', 'next_address', 'bytes_acknowledged')}, Progress_File)
+    os.replace(Progress['file'] + '.tmp', Progress['file'])
+
+def Remove_Transfer_Progress(Progress):
+    if(os.path.exists(Progress['file'])):
+        os.remove(Progress['file'])
+
+def Clip_Segments(Segments, Address):
+    ''' the part of the segments at or above Address '''
+    Clipped = []
+    for Segment_Address, Data in Segments:
+        if(Segment_Address + len(Data) > Address):
+            Skip = max(0, Address - Segment_Address)
+            Clipped.append((Segment_Address + Skip, Data[Skip:]))
+    return Clipped
+
+def Find_Resume_Offset(Base_Address, Image, Segments, Block_Offset):
+    ''' the first differing block may be half written : it resumes at its first differing byte when the bytes
+        from there on are erased , as is all the image after the block , None when the flash is not a prefix of the image '''
+    if(Block_Offset >= len(Image)):
+        return len(Image)
+    Block = Image[Block_Offset : Block_Offset + DIFF_BLOCK_SIZE]
+    Flash_Block = Read_Memory_Block(Base_Address + Block_Offset, len(Block))
+    if(Flash_Block is None):
+        return None
+    Byte_Offset = next((Offset for Offset in range(len(Block)) if Flash_Block[Offset] != Block[Offset]), len(Block))
+    ''' only the padding after the image differed , the flash there is outside the image '''
+    if(Block_Offset + Byte_Offset >= len(Image)):
+        return len(Image)
+    if(Flash_Block[Byte_Offset:].count(0xFF) != (len(Block) - Byte_Offset)):
+        return None
+    for Address, Data in Clip_Segments(Segments, Base_Address + Block_Offset + len(Block)):
+        Send_CBL_BLANK_CHECK_CMD(Address, len(Data))
+        if((Blank_Check_Result is None) or (Blank_Check_Result[0] != BLANK_CHECK_BLANK)):
+            return None
+    return Block_Offset + Byte_Offset
+
+def Input_Image_Segments():
+    Image_File_Name = input("\n   Enter the image file (.bin , .hex or .elf , Enter for Application.bin) : ") or "Application.bin"
+    BaseMemoryAddress = 0
+    if(not Is_Located_Image(Image_File_Name)):
+        ''' Get the start address to write the payload '''
+        BaseMemoryAddress = int(input("\n   Enter the start address : "), 16)
+    try:
+        Segments = Load_Image_Segments(Image_File_Name, BaseMemoryAddress)
+    except (OSError, ValueError) as Load_Error:
+        print("\n   Error !!", Load_Error)
+        return None
+    for Segment_Address, Segment_Data in Segments:
+        print("   Segment 0x{0:08x} : {1} Bytes".format(Segment_Address, len(Segment_Data)))
+    return Image_File_Name, Segments
+
+def Erase_Image_Sectors(Segments):
+    Sectors = Plan_Erase_Sectors(Segments)
+    if(Sectors is None):
+        print("\n   Error !! the image reaches the bootloader sectors or leaves the flash , nothing erased")
+        return 0
+    print("   Erasing sectors {0} (about {1} s)".format(Sectors, Erase_Time_Estimate(Sectors)))
+    return Erase_Flash_Sectors(Sectors)
 
 def Decode_CBL_Command(Command):
     BL_Host_Buffer = []
@@ -233,62 +1552,50 @@ def Decode_CBL_Command(Command):
         CBL_GET_VER_CMD_Len = 6
         BL_Host_Buffer[0] = CBL_GET_VER_CMD_Len - 1
         BL_Host_Buffer[1] = CBL_GET_VER_CMD
-        CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_GET_VER_CMD_Len - 4)
+        CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_VER_CMD_Len - 4)
         CRC32_Value = CRC32_Value & 0xFFFFFFFF
         print("Host CRC = ", hex(CRC32_Value))
         BL_Host_Buffer[2] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
         BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
         BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
         BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-        Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-        for Data in BL_Host_Buffer[1 : CBL_GET_VER_CMD_Len]:
-            Write_Data_To_Serial_Port(Data, CBL_GET_VER_CMD_Len - 1)
-        Read_Data_From_Serial_Port(CBL_GET_VER_CMD)
+        Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_VER_CMD_Len], CBL_GET_VER_CMD)
     elif (Command == 2):
         print("Read the commands supported by the bootloader")
         CBL_GET_HELP_CMD_Len = 6
         BL_Host_Buffer[0] = CBL_GET_HELP_CMD_Len - 1
         BL_Host_Buffer[1] = CBL_GET_HELP_CMD
-        CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_GET_HELP_CMD_Len - 4)
+        CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_HELP_CMD_Len - 4)
         CRC32_Value = CRC32_Value & 0xFFFFFFFF
         BL_Host_Buffer[2] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
         BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
         BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
         BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-        Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-        for Data in BL_Host_Buffer[1 : CBL_GET_HELP_CMD_Len]:
-            Write_Data_To_Serial_Port(Data, CBL_GET_HELP_CMD_Len - 1)
-        Read_Data_From_Serial_Port(CBL_GET_HELP_CMD)
+        Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_HELP_CMD_Len], CBL_GET_HELP_CMD)
     elif (Command == 3):
         print("Read the MCU chip identification number")
         CBL_GET_CID_CMD_Len = 6
         BL_Host_Buffer[0] = CBL_GET_CID_CMD_Len - 1
         BL_Host_Buffer[1] = CBL_GET_CID_CMD
-        CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_GET_CID_CMD_Len - 4)
+        CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_CID_CMD_Len - 4)
         CRC32_Value = CRC32_Value & 0xFFFFFFFF
         BL_Host_Buffer[2] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
         BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
         BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
         BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-        Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-        for Data in BL_Host_Buffer[1 : CBL_GET_CID_CMD_Len]:
-            Write_Data_To_Serial_Port(Data, CBL_GET_CID_CMD_Len - 1)
-        Read_Data_From_Serial_Port(CBL_GET_CID_CMD)
+        Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_CID_CMD_Len], CBL_GET_CID_CMD)
     elif (Command == 4):
         print("Read the FLASH Read Protection level")
         CBL_GET_RDP_STATUS_CMD_Len = 6
         BL_Host_Buffer[0] = CBL_GET_RDP_STATUS_CMD_Len - 1
         BL_Host_Buffer[1] = CBL_GET_RDP_STATUS_CMD
-        CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_GET_RDP_STATUS_CMD_Len - 4)
+        CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GET_RDP_STATUS_CMD_Len - 4)
         CRC32_Value = CRC32_Value & 0xFFFFFFFF
         BL_Host_Buffer[2] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
         BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
         BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
         BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-        Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-        for Data in BL_Host_Buffer[1 : CBL_GET_RDP_STATUS_CMD_Len]:
-            Write_Data_To_Serial_Port(Data, CBL_GET_RDP_STATUS_CMD_Len - 1)
-        Read_Data_From_Serial_Port(CBL_GET_RDP_STATUS_CMD)
+        Send_Command_Frame(BL_Host_Buffer[0 : CBL_GET_RDP_STATUS_CMD_Len], CBL_GET_RDP_STATUS_CMD)
     elif (Command == 5):
         print("Jump bootloader to specified address command")
         CBL_GO_TO_ADDR_CMD_Len = 10
@@ -300,124 +1607,59 @@ def Decode_CBL_Command(Command):
         BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CBL_Jump_Address, 2, 1) 
         BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CBL_Jump_Address, 3, 1) 
         BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CBL_Jump_Address, 4, 1)
-        CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_GO_TO_ADDR_CMD_Len - 4) 
+        CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_GO_TO_ADDR_CMD_Len - 4) 
         CRC32_Value = CRC32_Value & 0xFFFFFFFF
         BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
         BL_Host_Buffer[7] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
         BL_Host_Buffer[8] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
         BL_Host_Buffer[9] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-        Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-        for Data in BL_Host_Buffer[1 : CBL_GO_TO_ADDR_CMD_Len]:
-            Write_Data_To_Serial_Port(Data, CBL_GO_TO_ADDR_CMD_Len - 1)
-        Read_Data_From_Serial_Port(CBL_GO_TO_ADDR_CMD)
+        Send_Command_Frame(BL_Host_Buffer[0 : CBL_GO_TO_ADDR_CMD_Len], CBL_GO_TO_ADDR_CMD)
     elif (Command == 6):
-        print("Mass erase or sector erase of the user flash command")
-        CBL_FLASH_ERASE_CMD_Len = 8
+        print("Sector erase of the application flash command")
         SectorNumber = 0
         NumberOfSectors = 0
-        BL_Host_Buffer[0] = CBL_FLASH_ERASE_CMD_Len - 1
-        BL_Host_Buffer[1] = CBL_FLASH_ERASE_CMD
-        SectorNumber = input("\n   Please enter start sector number(0-11)          : ")
+        SectorNumber = input("\n   Please enter start sector number({0}-{1}) , A to plan it from an image : ".format(
+            APP_FIRST_SECTOR, len(FLASH_SECTOR_SIZES) - 1))
+        if(SectorNumber.strip().upper() == 'A'):
+            Image = Input_Image_Segments()
+            if(Image is not None):
+                Erase_Image_Sectors(Image[1])
+            return
         SectorNumber = int(SectorNumber, 16)
-        if(SectorNumber != 0xFF):
-            NumberOfSectors = int(input("\n   Please enter number of sectors to erase (12 Max): "), 16)
-        BL_Host_Buffer[2] = SectorNumber
-        BL_Host_Buffer[3] = NumberOfSectors
-        CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_FLASH_ERASE_CMD_Len - 4) 
-        CRC32_Value = CRC32_Value & 0xFFFFFFFF
-        BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
-        BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
-        BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
-        BL_Host_Buffer[7] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-        Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-        for Data in BL_Host_Buffer[1 : CBL_FLASH_ERASE_CMD_Len]:
-            Write_Data_To_Serial_Port(Data, CBL_FLASH_ERASE_CMD_Len - 1)
-        Read_Data_From_Serial_Port(CBL_FLASH_ERASE_CMD)
+        NumberOfSectors = int(input("\n   Please enter number of sectors to erase (1-{0}): ".format(
+            len(FLASH_SECTOR_SIZES) - SectorNumber)), 16)
+        Send_CBL_FLASH_ERASE_CMD(SectorNumber, NumberOfSectors)
     elif (Command == 7):
         print("Write data into different memories of the MCU command")
-        global Memory_Write_Is_Active
-        global Memory_Write_All
-        File_Total_Len = 0
-        BinFileRemainingBytes = 0
-        BinFileSentBytes = 0
-        BaseMemoryAddress = 0
-        BinFileReadLength = 0
-        Memory_Write_All = 1
-        
-        ''' Get the total length of the binary file '''
-        File_Total_Len = CalulateBinFileLength()
-        print("   Preparing writing a binary file with length (", File_Total_Len, ") Bytes")
-        ''' Open the binary file '''
-        OpenBinFile()
-        ''' Calculate the remaining payload '''
-        BinFileRemainingBytes = File_Total_Len - BinFileSentBytes
-        ''' Get the start address to write the payload '''
-        BaseMemoryAddress = input("\n   Enter the start address : ")
-        BaseMemoryAddress = int(BaseMemoryAddress, 16)
-        ''' Keep sending the write packet till the last payload byte '''
-        while(BinFileRemainingBytes):
-            ''' Memory write is active '''
-            Memory_Write_Is_Active = 1
-            
-            ''' Read 128 bytes from the binary file each time '''
-            if(BinFileRemainingBytes >= 128):
-                BinFileReadLength = 128
-            else:
-                BinFileReadLength = BinFileRemainingBytes
-            
-            for BinFileByte in range(BinFileReadLength):
-                BinFileByteValue = BinFile.read(1)
-                BinFileByteValue = bytearray(BinFileByteValue)
-                BL_Host_Buffer[7 + BinFileByte] = int(BinFileByteValue[0])
-            
-            ''' Update the Host packet with the command code ID '''
-            BL_Host_Buffer[1] = CBL_MEM_WRITE_CMD
-        
-            ''' Update the Host packet with the base address '''
-            BL_Host_Buffer[2] = Word_Value_To_Byte_Value(BaseMemoryAddress, 1, 1)
-            BL_Host_Buffer[3] = Word_Value_To_Byte_Value(BaseMemoryAddress, 2, 1)
-            BL_Host_Buffer[4] = Word_Value_To_Byte_Value(BaseMemoryAddress, 3, 1)
-            BL_Host_Buffer[5] = Word_Value_To_Byte_Value(BaseMemoryAddress, 4, 1)
-            
-            ''' Update the Host packet with the payload length '''
-            BL_Host_Buffer[6] = BinFileReadLength
-            
-            ''' Update the Host packet with the packet length '''
-            CBL_MEM_WRITE_CMD_Len = (BinFileReadLength + 11)
-            BL_Host_Buffer[0] = CBL_MEM_WRITE_CMD_Len - 1
-            
-            ''' Update the Host packet with the calculated CRC32 '''
-            CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_MEM_WRITE_CMD_Len - 4) 
-            CRC32_Value = CRC32_Value & 0xFFFFFFFF
-            BL_Host_Buffer[7 + BinFileReadLength] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
-            BL_Host_Buffer[8 + BinFileReadLength] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
-            BL_Host_Buffer[9 + BinFileReadLength] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
-            BL_Host_Buffer[10+ BinFileReadLength] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-            
-            ''' Calculate the next Base memory address '''
-            BaseMemoryAddress = BaseMemoryAddress + BinFileReadLength
-            
-            ''' Send the packet length to the bootloader '''
-            Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-            
-            ''' Send the complete packet to the bootloader '''
-            for Data in BL_Host_Buffer[1 : CBL_MEM_WRITE_CMD_Len]:
-                Write_Data_To_Serial_Port(Data, CBL_MEM_WRITE_CMD_Len - 1)
-            
-            ''' Update the total number of bytes sent to the bootloader '''
-            BinFileSentBytes = BinFileSentBytes + BinFileReadLength
-            
-            ''' Calculate the remaining payload '''
-            BinFileRemainingBytes = File_Total_Len - BinFileSentBytes
-            print("\n   Bytes sent to the bootloader :{0}".format(BinFileSentBytes))
-            
-            ''' Read the response from the bootloader '''
-            BL_Return_Value = Read_Data_From_Serial_Port(CBL_MEM_WRITE_CMD)
-            sleep(0.1)
-        ''' Memory write is inactive '''
-        Memory_Write_Is_Active = 0
+        Image = Input_Image_Segments()
+        if(Image is None):
+            return
+        Image_File_Name, Segments = Image
+        Progress = Open_Transfer_Progress(Progress_File_Name(Image_File_Name, Serial_Port_Obj.port), Segments)
+        if(Progress['saved'] and (input("\n   An interrupted transfer of this image was found , resume it (Y/n) : ").strip().upper() != 'N')):
+            Report = {}
+            Resume_Flash_Image(Segments, 0, Report, Progress)
+            print("\n   Resume Status ->", Report.get('error', "Payload Written Successfully"), Report.get('resume', ''))
+            return
+        Sparse = Segments
+        if(input("\n   Erase the sectors the image covers first (Y/n) : ").strip().upper() != 'N'):
+            if(Erase_Image_Sectors(Segments) == 0):
+                return
+            Sparse = Sparse_Segments(Segments)
+        print("   Sending {0} of {1} Bytes , the rest is erased flash".format(
+            sum(len(Data) for Address, Data in Sparse), sum(len(Data) for Address, Data in Segments)))
+        Send_Memory_Write_Frames(Build_Image_Frames(Sparse, Session), Progress)
         if(Memory_Write_All == 1):
             print("\n\n Payload Written Successfully")
+            ''' Record the new sector CRCs , the bootloader only starts images matching its manifest '''
+            print("\n   Committing the sector CRC manifest")
+            Send_CBL_SECTOR_MANIFEST_CMD(MANIFEST_OP_COMMIT, 0)
+            if(Manifest_Status == MANIFEST_REQUEST_VALID):
+                Remove_Transfer_Progress(Progress)
+            else:
+                print("\n   Progress kept in", Progress['file'], ", resume to commit the manifest again")
+        else:
+            print("\n   Progress saved to", Progress['file'], ", choose this image again to resume")
     elif (Command == 8):
         print("Change read protection level of the user flash command")
         Protection_level = input("\n   Please Enter one of these Protection levels : 0,1,2 : ")
@@ -430,43 +1672,420 @@ def Decode_CBL_Command(Command):
             BL_Host_Buffer[0] = CBL_CHANGE_ROP_Level_CMD_Len - 1
             BL_Host_Buffer[1] = CBL_CHANGE_ROP_Level_CMD
             BL_Host_Buffer[2] = Protection_level
-            CRC32_Value = Calculate_CRC32(BL_Host_Buffer, CBL_CHANGE_ROP_Level_CMD_Len - 4) 
+            CRC32_Value = Calculate_Frame_CRC32(BL_Host_Buffer, CBL_CHANGE_ROP_Level_CMD_Len - 4) 
             CRC32_Value = CRC32_Value & 0xFFFFFFFF
             BL_Host_Buffer[3] = Word_Value_To_Byte_Value(CRC32_Value, 1, 1)
             BL_Host_Buffer[4] = Word_Value_To_Byte_Value(CRC32_Value, 2, 1)
             BL_Host_Buffer[5] = Word_Value_To_Byte_Value(CRC32_Value, 3, 1)
             BL_Host_Buffer[6] = Word_Value_To_Byte_Value(CRC32_Value, 4, 1)
-            Write_Data_To_Serial_Port(BL_Host_Buffer[0], 1)
-            for Data in BL_Host_Buffer[1 : CBL_CHANGE_ROP_Level_CMD_Len]:
-                Write_Data_To_Serial_Port(Data, CBL_CHANGE_ROP_Level_CMD_Len - 1)
-            Read_Data_From_Serial_Port(CBL_CHANGE_ROP_Level_CMD)
+            Send_Command_Frame(BL_Host_Buffer[0 : CBL_CHANGE_ROP_Level_CMD_Len], CBL_CHANGE_ROP_Level_CMD)
         else:
             print("\n   Protection level (", Protection_level, ") not supported !!")
+    elif (Command == 9):
+        print("Calculate SHA-256 of a memory region or of the written data command")
+        global SHA256_Hashed_Length
+        SHA256_Region_Address = 0
+        SHA256_Hashed_Length = 0
+        SHA256_Mode = int(input("\n   Enter 0 to hash a region , 1 to hash the data written since last request : "), 16)
+        if(SHA256_Mode == SHA256_MODE_REGION):
+            SHA256_Region_Address = int(input("\n   Enter the region start address : "), 16)
+            SHA256_Hashed_Length = int(input("\n   Enter the region length in bytes (Hex) : "), 16)
+        Send_CBL_GET_SHA256_CMD(SHA256_Mode, SHA256_Region_Address, SHA256_Hashed_Length)
+    elif (Command == 10):
+        print("Read , validate or commit the sector CRC manifest command")
+        CBL_SECTOR_MANIFEST_CMD_Len = 8
+        Manifest_Op = int(input("\n   Enter 0 to read , 1 to validate , 2 to commit : "), 16)
+        Sector_Mask = 0
+        if(Manifest_Op == MANIFEST_OP_VALIDATE):
+            Sector_Mask = int(input("\n   Enter the sectors mask to validate (bit 0 -> sector 4 , Hex) : "), 16)
+        Send_CBL_SECTOR_MANIFEST_CMD(Manifest_Op, Sector_Mask)
+    elif (Command == 11):
+        print("Read the image slots or clear their boot attempts command")
+        Slot_Op = int(input("\n   Enter 0 to read , 1 to clear the boot attempts : "), 16)
+        Send_CBL_SLOT_INFO_CMD(Slot_Op)
+    elif (Command == 12):
+        print("Stamp the image header onto Application.bin")
+        Header_Address = int(input("\n   Enter the address the image will be written at (slot base or 0x8010000) : "), 16)
+        Fw_Version = int(input("\n   Enter the firmware version (Hex) : "), 16)
+        Stamp_Image_Header(Header_Address, Fw_Version)
+    elif (Command == 13):
+        print("Read the boot timestamps and command timing command")
+        global Timing_Print_Boot
+        Timing_Print_Boot = 1
+        Command_Code = int(input("\n   Enter the command code to report (Hex) , 0 for every command : "), 16)
+        if(Command_Code == 0):
+            Command_Codes = range(CBL_GET_VER_CMD, CBL_GET_TIMING_CMD + 1)
+        else:
+            Command_Codes = [Command_Code]
+        for Command_Code in Command_Codes:
+            print("\n   Command 0x{0:02x}".format(Command_Code), end = ' ')
+            Send_CBL_GET_TIMING_CMD(Command_Code)
+    elif (Command == 14):
+        print("Load a RAM stub into the stub region and run it command")
+        Stub_File_Name = input("\n   Enter the stub binary file name (linked at 0x{0:08x}) : ".format(STUB_RAM_BASE))
+        Stub_Arg = int(input("\n   Enter the stub argument (Hex) : "), 16)
+        with open(Stub_File_Name, 'rb') as Stub_File:
+            Stub = Prepare_Stub_Image(Stub_File.read())
+        if(Stub is None):
+            print("\n   Error !! the file does not start with a stub header")
+        elif(len(Stub) > STUB_RAM_SIZE):
+            print("\n   Error !! the stub does not fit the stub region")
+        elif(Write_Memory_Block(STUB_RAM_BASE, Stub) == 1):
+            Send_CBL_EXEC_RAM_STUB_CMD(STUB_RAM_BASE, Stub_Arg)
+        else:
+            print("\n   Error !! loading the stub failed")
+    elif (Command == 15):
+        print("Read flash or SRAM back command")
+        Read_Address = int(input("\n   Enter the start address (Hex) : "), 16)
+        Read_Length = int(input("\n   Enter the number of bytes to read (Hex) : "), 16)
+        Dump_File_Name = input("\n   Enter the output file name (empty to print) : ")
+        Dump = Read_Memory_Block(Read_Address, Read_Length)
+        if(Dump is None):
+            print("\n   Error !! memory read failed")
+        elif(Dump_File_Name):
+            with open(Dump_File_Name, 'wb') as Dump_File:
+                Dump_File.write(Dump)
+            print("\n   {0} bytes written to {1}".format(len(Dump), Dump_File_Name))
+        else:
+            for Offset in range(0, len(Dump), 16):
+                print("   0x{0:08x} : {1}".format(Read_Address + Offset, Dump[Offset : Offset + 16].hex(' ')))
+    elif (Command == 16):
+        print("Stream a memory range to a file command")
+        Dump_Address = int(input("\n   Enter the start address (Hex) : "), 16)
+        Dump_Length = int(input("\n   Enter the number of bytes to dump (Hex) : "), 16)
+        Dump_Window = int(input("\n   Enter the window , blocks in flight (1 - {0}) : ".format(DUMP_MAX_WINDOW)))
+        Dump_File_Name = input("\n   Enter the output file name : ")
+        Dump = Dump_Memory(Dump_Address, Dump_Length, Dump_Window)
+        if(Dump is None):
+            print("\n   Error !! memory dump failed")
+        else:
+            with open(Dump_File_Name, 'wb') as Dump_File:
+                Dump_File.write(Dump)
+            print("\n   {0} bytes written to {1}".format(len(Dump), Dump_File_Name))
+    elif (Command == 17):
+        print("Blank check a flash range command")
+        Check_Address = int(input("\n   Enter the start address (Hex) : "), 16)
+        Check_Length = int(input("\n   Enter the number of bytes to check (Hex) : "), 16)
+        Send_CBL_BLANK_CHECK_CMD(Check_Address, Check_Length)
+    elif (Command == 18):
+        print("Re-flash only the blocks of a binary that differ from the flash")
+        Image_File_Name = input("\n   Enter the binary file name : ")
+        Base_Address = int(input("\n   Enter the address the binary is written at (Hex) : "), 16)
+        with open(Image_File_Name, 'rb') as Image_File:
+            Image = Image_File.read()
+        if(Flash_Changed_Blocks(Base_Address, Image) == 1):
+            print("\n   Flash is up to date")
+        else:
+            print("\n   Error !! block re-flash failed")
+    elif (Command == 19):
+        print("Read the device information bundle command")
+        Send_CBL_GET_DEVICE_INFO_CMD()
+    elif (Command == 20):
+        print("Open a session with faster transfer parameters command")
+        Frame_Size = int(input("\n   Enter the frame size (16 - {0}) : ".format(MAX_FRAME_SIZE)))
+        Window = int(input("\n   Enter the dump window (1 - {0}) : ".format(DUMP_MAX_WINDOW)))
+        CRC_Mode = int(input("\n   Enter 0 for byte CRC , 1 for word CRC : "))
+        Compression = int(input("\n   Enter 1 to compress memory writes , 0 otherwise : "))
+        Baud_Rate = int(input("\n   Enter the baud rate (115200 , 230400 , 460800 , 921600) : "))
+        Send_CBL_SESSION_OPEN_CMD(Frame_Size, Window, CRC_Mode, Compression, Baud_Rate)
+    elif (Command == 21):
+        print("Save the link metrics of this session")
+        Metrics_File_Name = input("\n   Enter the report file (Enter for Host_Metrics.json) : ") or "Host_Metrics.json"
+        Save_Link_Metrics(Metrics_File_Name)
+        Report = Link_Metrics_Report()
+        print("   {0} frames , {1} retries , {2} payload Bytes/s , report saved to {3}".format(
+            Report['frames'], Report['retries'], Report['payload_bytes_per_s'], Metrics_File_Name))
             
         
 
-SerialPortName = input("Enter the Port Name of your device(Ex: COM3):")
-Serial_Port_Configuration(SerialPortName)
-        
-while True:
-    print("\nSTM32F407 Custome BootLoader")
-    print("==============================")
-    print("Which command you need to send to the bootLoader :");
-    print("   CBL_GET_VER_CMD              --> 1")
-    print("   CBL_GET_HELP_CMD             --> 2")
-    print("   CBL_GET_CID_CMD              --> 3")
-    print("   CBL_GET_RDP_STATUS_CMD       --> 4")
-    print("   CBL_GO_TO_ADDR_CMD           --> 5")
-    print("   CBL_FLASH_ERASE_CMD          --> 6")
-    print("   CBL_MEM_WRITE_CMD            --> 7")
-    print("   CBL_CHANGE_ROP_Level_CMD     --> 8")
-    
-    CBL_Command = input("\nEnter the command code : ")
+def Verify_Flash_Image(Base_Address, Image):
+    ''' the bootloader hashes the flashed range , 1 when it matches the local image '''
+    Send_CBL_GET_SHA256_CMD(SHA256_MODE_REGION, Base_Address, len(Image))
+    return int(SHA256_Digest == hashlib.sha256(Image).digest())
+
+def Verify_Image_Segments(Segments):
+    ''' every segment whole , the skipped 0xFF runs are checked as well '''
+    return int(all(Verify_Flash_Image(Address, Data) for Address, Data in Segments))
+
+def Flash_Image(Segments, Erase_Mode, Verify, Report, Frames = None, Progress = None):
+    ''' erase , write , commit the manifest and verify , the outcome goes into Report '''
+    Report.update({'segments' : [["0x{0:08x}".format(Address), len(Data)] for Address, Data in Segments],
+                   'bytes' : sum(len(Data) for Address, Data in Segments), 'erase' : Erase_Mode, 'erased_sectors' : []})
+    if(Erase_Mode == 'changed'):
+        Written = Flash_Changed_Blocks(*Flatten_Segments(Segments))
+    else:
+        if(Erase_Mode == 'auto'):
+            Sectors = Plan_Erase_Sectors(Segments)
+            if(Sectors is None):
+                Report['error'] = "image overlaps the bootloader sectors or leaves the flash"
+                return
+            Report['erase_estimate_s'] = Erase_Time_Estimate(Sectors)
+            if(Erase_Flash_Sectors(Sectors) == 0):
+                Report['error'] = "erase failed"
+                return
+            Report['erased_sectors'] = Sectors
+        if(Frames is None):
+            Frames = Build_Image_Frames(Sparse_Segments(Segments) if(Erase_Mode == 'auto') else Segments, Session)
+        Report['frames'] = len(Frames)
+        Written = Send_Memory_Write_Frames(Frames, Progress)
+    if(Written == 0):
+        Report['error'] = "write failed"
+        return
+    Finish_Flash_Image(Segments, Verify, Report, Progress)
+
+def Finish_Flash_Image(Segments, Verify, Report, Progress):
+    ''' Record the new sector CRCs , the bootloader only starts images matching its manifest '''
+    Send_CBL_SECTOR_MANIFEST_CMD(MANIFEST_OP_COMMIT, 0)
+    if(Manifest_Status != MANIFEST_REQUEST_VALID):
+        ''' refused or no reply , an unstamped image is not started in single image mode '''
+        Report['error'] = "manifest commit failed"
+        return
+    if(Verify):
+        Report['verified'] = bool(Verify_Image_Segments(Segments))
+        if(not Report['verified']):
+            Report['error'] = "verify mismatch"
+            return
+    ''' the transfer is only done once the manifest is committed and the image verified '''
+    if(Progress is not None):
+        Remove_Transfer_Progress(Progress)
+
+def Resume_Flash_Image(Segments, Verify, Report, Progress):
+    ''' continue an interrupted transfer from the first block whose CRC the bootloader does not match '''
+    if(Progress['saved']):
+        Report['progress_next_address'] = "0x{0:08x}".format(Progress['next_address']) if Progress['next_address'] else None
+    if((Plan_Erase_Sectors(Segments) is None) or any(Flash_Sector_Of(Address) is None for Address, Data in Segments)):
+        Report['resume'] = "not possible , the image is not all in application flash"
+        return Flash_Image(Segments, 'auto', Verify, Report, None, Progress)
+    ''' each segment is diffed on its own , the gaps between them were never erased for this image '''
+    Bytes_On_Device = 0
+    Resume_Address = None
+    for Address, Data in Segments:
+        Changed_Blocks = Diff_Flash_Image(Address, Data)
+        if(Changed_Blocks is None):
+            Report['error'] = "block diff refused"
+            return
+        Resume_Offset = Find_Resume_Offset(Address, Data, Segments,
+                                           (Changed_Blocks[0] * DIFF_BLOCK_SIZE) if Changed_Blocks else len(Data))
+        if(Resume_Offset is None):
+            Report['resume'] = "the flash does not hold a part of this image , starting over"
+            Progress['next_address'] = None
+            Progress['bytes_acknowledged'] = 0
+            return Flash_Image(Segments, 'auto', Verify, Report, None, Progress)
+        Bytes_On_Device += Resume_Offset
+        if(Resume_Offset < len(Data)):
+            Resume_Address = Address + Resume_Offset
+            break
+    Report['resume'] = "resumed at 0x{0:08x}".format(Resume_Address) if Resume_Address is not None else "the image is already on the device"
+    Remaining = Clip_Segments(Segments, Resume_Address) if Resume_Address is not None else []
+    Report.update({'segments' : [["0x{0:08x}".format(Address), len(Data)] for Address, Data in Segments],
+                   'bytes' : sum(len(Data) for Address, Data in Segments), 'erase' : 'resume', 'erased_sectors' : [],
+                   'bytes_already_on_device' : Bytes_On_Device})
+    Frames = Build_Image_Frames(Sparse_Segments(Remaining), Session)
+    Report['frames'] = len(Frames)
+    if(Send_Memory_Write_Frames(Frames, Progress) == 0):
+        Report['error'] = "write failed"
+        return
+    Finish_Flash_Image(Segments, Verify, Report, Progress)
+
+def Requested_Session(Baud_Rate):
+    ''' the session --baud asks for , the frames of a gang run are built for it before any board answers '''
+    if(not Baud_Rate):
+        return dict(Session)
+    return {'Open' : 1, 'Frame_Size' : MAX_FRAME_SIZE, 'Window' : DUMP_MAX_WINDOW, 'CRC_Mode' : SESSION_CRC_WORD, 'Compression' : 1}
+
+def Run_CLI_Command(Args, Port, Report):
+    try:
+        Port_Status = Serial_Port_Configuration(Port)
+    except EnvironmentError:
+        Port_Status = -1
+    if(Port_Status == -1):
+        Report['error'] = "port open failed"
+        return EXIT_NO_RESPONSE
+    if(Args.baud):
+        Prepared = Requested_Session(Args.baud)
+        Send_CBL_SESSION_OPEN_CMD(Prepared['Frame_Size'], Prepared['Window'], Prepared['CRC_Mode'], Prepared['Compression'], Args.baud)
+    if(Args.baud and not Session['Open']):
+        Report['error'] = "session refused"
+    elif(Args.command == 'flash'):
+        Frames = Args.frames
+        if(Frames and (Requested_Session(Args.baud) != Session)):
+            ''' this board granted less than asked , its frames are rebuilt '''
+            Frames = None
+        ''' an --erase auto transfer keeps its progress so a later --resume can continue it '''
+        Progress = Open_Transfer_Progress(Progress_File_Name(Args.file, Port), Args.segments) if(Args.erase == 'auto') else None
+        if(Args.resume):
+            Resume_Flash_Image(Args.segments, Args.verify, Report, Progress)
+        else:
+            Flash_Image(Args.segments, Args.erase, Args.verify, Report, Frames, Progress)
+    elif(Args.command == 'verify'):
+        Report['verified'] = bool(Verify_Image_Segments(Args.segments))
+        if(not Report['verified']):
+            Report['error'] = "verify mismatch"
+    elif(Args.command == 'erase'):
+        if(Args.sector < APP_FIRST_SECTOR):
+            Report['error'] = "refusing to erase the bootloader sectors"
+        elif(Args.count < 1):
+            Report['error'] = "sector count must be at least 1"
+        elif(Erase_Flash_Sectors(range(Args.sector, Args.sector + Args.count)) == 0):
+            Report['error'] = "erase failed"
+    elif(Args.command == 'read'):
+        Data = Read_Memory_Block(Args.addr, Args.length)
+        if(Data is None):
+            Report['error'] = "read failed"
+        elif(Args.output):
+            with open(Args.output, 'wb') as Output_File:
+                Output_File.write(Data)
+        else:
+            Report['data'] = Data.hex()
+    elif(Args.command == 'info'):
+        Send_CBL_GET_DEVICE_INFO_CMD()
+        Report['device'] = Device_Info
+        if(Device_Info is None):
+            Report['error'] = "no device information"
+    if(Session['Open']):
+        Close_Session()
+    Serial_Port_Obj.close()
+    if('error' not in Report):
+        return EXIT_OK
+    ''' a frame whose last attempt ran into its deadline means the board is gone , a NACK means it refused '''
+    return EXIT_NO_RESPONSE if(Unanswered_Frames) else EXIT_FAILED
+
+def Run_CLI_Port(Args, Port, Quiet):
+    ''' one port , the report carries its own timing and exit code '''
+    Report = {'command' : Args.command, 'port' : Port}
+    Start_Time = monotonic()
+    with open(os.devnull, 'w') if Quiet else contextlib.nullcontext(sys.stderr) as Log:
+        with contextlib.redirect_stdout(Log):
+            Exit_Code = Run_CLI_Command(Args, Port, Report)
+    if(Args.metrics):
+        Report['metrics'] = Link_Metrics_Report()
+    Report['result'] = 'ok' if(Exit_Code == EXIT_OK) else 'failed'
+    Report['exit_code'] = Exit_Code
+    Report['elapsed_s'] = round(monotonic() - Start_Time, 3)
+    return Report
+
+def Run_Gang_Flash(Args):
+    ''' one process per port , every board has its own link state , the station takes as long as the slowest board '''
+    Start_Time = monotonic()
+    with multiprocessing.Pool(len(Args.port)) as Gang:
+        Reports = Gang.starmap(Run_CLI_Port, [(Args, Port, True) for Port in Args.port])
+    Elapsed = monotonic() - Start_Time
+    for Report in Reports:
+        print("   {0:<16} {1:<6} {2:7.2f} s  {3}".format(Report['port'], Report['result'], Report['elapsed_s'],
+              Report.get('error', '')), file = sys.stderr)
+    Failed = [Report['exit_code'] for Report in Reports if Report['exit_code'] != EXIT_OK]
+    return {'command' : 'flash', 'ports' : Reports,
+            'passed' : len(Reports) - len(Failed), 'failed' : len(Failed),
+            'result' : 'failed' if Failed else 'ok',
+            'exit_code' : max(Failed) if Failed else EXIT_OK,
+            'elapsed_s' : round(Elapsed, 3),
+            'slowest_s' : max(Report['elapsed_s'] for Report in Reports),
+            'sequential_s' : round(sum(Report['elapsed_s'] for Report in Reports), 3)}
+
+def CLI_Main(Arguments):
+    ''' Host.py --port <port> <command> ... , one JSON object on stdout and the exit code tell the result '''
+    Parser = argparse.ArgumentParser(prog = 'Host.py', description = 'Scripted access to the custom bootloader')
+    Parser.add_argument('--port', required = True, action = 'append',
+                        help = 'serial port or pyserial URL of the board , repeat it to flash several boards at once')
+    Parser.add_argument('--baud', type = int, help = 'open a session at this baud rate with the largest frame')
+    Parser.add_argument('--quiet', action = 'store_true', help = 'drop the progress log written to stderr')
+    Parser.add_argument('--metrics', help = 'write the link metrics (RTT , retries , throughput) as JSON to this file')
+    Commands = Parser.add_subparsers(dest = 'command', required = True)
+    Flash_Parser = Commands.add_parser('flash', help = 'erase , write and commit an image')
+    Flash_Parser.add_argument('file', help = '.bin , Intel .hex or .elf')
+    Flash_Parser.add_argument('--addr', type = lambda Text: int(Text, 0), default = APP_BASE_ADDRESS,
+                              help = 'load address of a .bin , .hex and .elf carry their own')
+    Flash_Parser.add_argument('--erase', choices = ['auto', 'changed', 'none'], default = 'auto',
+                              help = 'auto : only the sectors the image segments cover , changed : only sectors of changed blocks')
+    Flash_Parser.add_argument('--verify', action = 'store_true', help = 'compare the SHA-256 of the flashed range')
+    Flash_Parser.add_argument('--resume', action = 'store_true',
+                              help = 'keep the progress next to the image and continue from the first block the board does not hold')
+    Verify_Parser = Commands.add_parser('verify', help = 'compare the flash with an image')
+    Verify_Parser.add_argument('file', help = '.bin , Intel .hex or .elf')
+    Verify_Parser.add_argument('--addr', type = lambda Text: int(Text, 0), default = APP_BASE_ADDRESS,
+                               help = 'load address of a .bin , .hex and .elf carry their own')
+    Erase_Parser = Commands.add_parser('erase', help = 'erase application sectors')
+    Erase_Parser.add_argument('sector', type = int)
+    Erase_Parser.add_argument('count', type = int, nargs = '?', default = 1, help = 'sectors from the start sector , 1 or more')
+    Read_Parser = Commands.add_parser('read', help = 'read memory , hex in the JSON result unless --output is given')
+    Read_Parser.add_argument('addr', type = lambda Text: int(Text, 0))
+    Read_Parser.add_argument('length', type = lambda Text: int(Text, 0))
+    Read_Parser.add_argument('--output')
+    Commands.add_parser('info', help = 'device information')
+    Args = Parser.parse_args(Arguments)
+    if((len(Args.port) > 1) and (Args.command != 'flash')):
+        Parser.error("several ports are only supported by flash")
     
-    if(not CBL_Command.isdigit()):
-        print("   Error !!, Please enter a valid command !! \n")
+    Args.segments = None
+    Args.frames = None
+    if(Args.command in ('flash', 'verify')):
+        try:
+            Args.segments = Load_Image_Segments(Args.file, Args.addr)
+        except (OSError, ValueError) as Load_Error:
+            Parser.error(str(Load_Error))
+    if((Args.command == 'flash') and Args.resume and (Args.erase != 'auto')):
+        Parser.error("--resume continues an --erase auto transfer")
+    if(len(Args.port) > 1):
+        if(Args.erase == 'changed'):
+            Parser.error("--erase changed diffs every board on its own , use auto or none with several ports")
+        ''' packets and CRCs are built once for every board '''
+        Args.frames = Build_Image_Frames(Sparse_Segments(Args.segments) if(Args.erase == 'auto') else Args.segments,
+                                         Requested_Session(Args.baud))
+        Report = Run_Gang_Flash(Args)
     else:
-        Decode_CBL_Command(int(CBL_Command))
+        Report = Run_CLI_Port(Args, Args.port[0], Args.quiet)
+    if(Args.metrics):
+        if('ports' in Report):
+            Metrics = {Port_Report['port'] : Port_Report.pop('metrics', None) for Port_Report in Report['ports']}
+        else:
+            Metrics = Report.pop('metrics')
+        with open(Args.metrics, 'w') as Metrics_File:
+            json.dump(Metrics, Metrics_File, indent = 2)
+    print(json.dumps(Report))
+    return Report['exit_code']
+
+def Interactive_Main():
+    SerialPortName = input("Enter the Port Name of your device(Ex: COM3 , /dev/ttyUSB0 , /dev/ttyACM0 or /dev/pts/3):")
+    Serial_Port_Configuration(SerialPortName)
     
-    input("\nPlease press any key to continue ...")
-    Serial_Port_Obj.reset_input_buffer()
\ No newline at end of file
+    while True:
+        print("\nSTM32F401 Custom BootLoader")
+        print("==============================")
+        print("Which command you need to send to the bootLoader :");
+        print("   CBL_GET_VER_CMD              --> 1")
+        print("   CBL_GET_HELP_CMD             --> 2")
+        print("   CBL_GET_CID_CMD              --> 3")
+        print("   CBL_GET_RDP_STATUS_CMD       --> 4")
+        print("   CBL_GO_TO_ADDR_CMD           --> 5")
+        print("   CBL_FLASH_ERASE_CMD          --> 6")
+        print("   CBL_MEM_WRITE_CMD            --> 7")
+        print("   CBL_CHANGE_ROP_Level_CMD     --> 8")
+        print("   CBL_GET_SHA256_CMD           --> 9")
+        print("   CBL_SECTOR_MANIFEST_CMD      --> 10")
+        print("   CBL_SLOT_INFO_CMD            --> 11")
+        print("   Stamp Application.bin header --> 12")
+        print("   CBL_GET_TIMING_CMD           --> 13")
+        print("   CBL_EXEC_RAM_STUB_CMD        --> 14")
+        print("   CBL_MEM_READ_CMD             --> 15")
+        print("   CBL_MEM_DUMP_CMD             --> 16")
+        print("   CBL_BLANK_CHECK_CMD          --> 17")
+        print("   Re-flash changed blocks      --> 18")
+        print("   CBL_GET_DEVICE_INFO_CMD      --> 19")
+        print("   CBL_SESSION_OPEN_CMD         --> 20")
+        print("   Save link metrics report     --> 21")
+
+        CBL_Command = input("\nEnter the command code : ")
+
+        if(not CBL_Command.isdigit()):
+            print("   Error !!, Please enter a valid command !! \n")
+        else:
+            Expire_Idle_Session()
+            Decode_CBL_Command(int(CBL_Command))
+
+        input("\nPlease press any key to continue ...")
+        Serial_Port_Obj.reset_input_buffer()
+
+if(__name__ == '__main__'):
+    if(len(sys.argv) > 1):
+        sys.exit(CLI_Main(sys.argv[1:]))
+    Interactive_Main()
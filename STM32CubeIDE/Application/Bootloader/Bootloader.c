@@ -12,7 +12,7 @@
 #include "Bootloader_private.h"
 
 
-static void Bootloader_Jump_to_user_main(void);
+static void Bootloader_Jump_to_user_main(uint32_t ImageBase);
 static void Bootloader_Get_Version(void);
 static void Bootloader_Get_Help(void);
 static void Bootloader_Get_Chip_ID(void);
@@ -24,13 +24,43 @@ static uint8_t Bootloader_CRC_Verifiy(uint32_t dataLen ,uint32_t HostCRC);
 static void Bootloader_SendAck(uint8_t ReplyMessageLength);
 static void Bootloader_SendNAck(void);
 static void BootLoader_SendData(uint8_t* pData , uint32_t DataLen);
+static void BootLoader_SendData_Start(const uint8_t* pData , uint32_t DataLen);
+static void BootLoader_SendData_Wait(void);
+static uint32_t Bootloader_CRC_Accumulate_Bytes(const uint8_t* pData , uint32_t DataLen);
 static uint8_t Bootloader_Host_Jump_Address_verification(uint32_t JumpAdress);
 static uint8_t Perfrom_Flash_Erase(uint8_t SectorNum , uint8_t NumberOfSectors);
 static uint8_t Perfrom_Memory_Write(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress);
+static uint8_t Perfrom_Flash_Write(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress);
+static uint8_t Perfrom_SRAM_Write(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress);
+static uint8_t Bootloader_Find_Write_Region(uint32_t StartMemAddress , uint32_t DataLen);
 static uint8_t BL_Read_Flash_Protection_Level(void);
 static void Bootloader_ChangeReadProtection(void);
 static uint8_t BL_Change_ROP_Level(uint8_t RDP_Level);
 static BL_Stat_t BL_PrintMsg(const char* format , ... );
+static void Bootloader_Get_SHA256(void);
+static void Bootloader_Sector_Manifest(void);
+static void Bootloader_Slot_Info(void);
+static void Bootloader_Get_Timing(void);
+static void Bootloader_Exec_RAM_Stub(void);
+static void Bootloader_Memory_Read(void);
+static uint8_t Bootloader_Is_Readable_Range(uint32_t StartMemAddress , uint32_t DataLen);
+static void Bootloader_Memory_Dump(void);
+static void Bootloader_Blank_Check(void);
+static uint32_t Bootloader_Find_Non_Blank(uint32_t Address , uint32_t DataLen);
+static void Bootloader_Block_Diff(void);
+static void Bootloader_Get_Device_Info(void);
+static uint32_t Bootloader_Feature_Flags(void);
+static void Bootloader_Session_Open(void);
+static void Bootloader_Session_Close(void);
+static uint8_t Bootloader_Is_Supported_Baud_Rate(uint32_t BaudRate);
+#ifdef BL_ENABLE_COMPRESSION
+static uint8_t Bootloader_Unpack_Payload(const uint8_t* pSrc , uint32_t SrcLen , uint8_t* pDst , uint8_t DstLen);
+#endif
+static void Bootloader_Dump_Stream(uint32_t DumpAddress , uint32_t DumpLen , uint8_t Window);
+static void Bootloader_Dump_Send_Block(uint32_t DumpAddress , uint32_t DumpLen , uint16_t BlockIndex);
+static void Bootloader_Dump_Rx_Start(void);
+static void Bootloader_Dump_Rx_Stop(void);
+static uint8_t Bootloader_Dump_Rx_Frame(uint8_t* pFrame);
 
 /* Array of pointer to helper functions of bootloader commands*/
 static BL_HelperCommandpFunc BL_HelperFunc[BL_NUMBER_OF_COMMAND] = {
@@ -41,14 +71,57 @@ static BL_HelperCommandpFunc BL_HelperFunc[BL_NUMBER_OF_COMMAND] = {
 		Bootloader_Jump_to_Address,
 		Bootloader_Erase_Flash,
 		Bootloader_Memory_Write,
-		Bootloader_ChangeReadProtection
+		Bootloader_ChangeReadProtection,
+		Bootloader_Get_SHA256,
+		Bootloader_Sector_Manifest,
+		Bootloader_Slot_Info,
+		Bootloader_Get_Timing,
+		Bootloader_Exec_RAM_Stub,
+		Bootloader_Memory_Read,
+		Bootloader_Memory_Dump,
+		Bootloader_Blank_Check,
+		Bootloader_Block_Diff,
+		Bootloader_Get_Device_Info,
+		Bootloader_Session_Open
 };
 /*****************************************/
 
 
+/* Write backend per memory region , bootloader flash and RAM are not writable by the host */
+static const BL_Write_Region_t BL_Write_Regions[BL_NUMBER_OF_WRITE_REGIONS] = {
+		{FLASH_SECTOR4_BASE_ADDRESS , BL_STM32401_FLASH_END , Perfrom_Flash_Write},
+		{BL_STUB_RAM_BASE , BL_STUB_RAM_END , Perfrom_SRAM_Write}
+};
+
 /* private Global Variable*/
 static uint8_t BL_HOST_BUFFER[BL_HOST_BUFFER_RX_MAX_SIZE];
-static uint8_t BL_Commands[8U] = {CBL_GET_VER_CMD,CBL_GET_HELP_CMD,CBL_GET_CID_CMD,CBL_GET_RDP_STATUS_CMD,CBL_GO_TO_ADDR_CMD,CBL_FLASH_ERASE_CMD,CBL_MEM_WRITE_CMD,CBL_CHANGE_ROP_Level_CMD};
+static uint8_t BL_Commands[BL_NUMBER_OF_COMMAND] = {CBL_GET_VER_CMD,CBL_GET_HELP_CMD,CBL_GET_CID_CMD,CBL_GET_RDP_STATUS_CMD,CBL_GO_TO_ADDR_CMD,CBL_FLASH_ERASE_CMD,CBL_MEM_WRITE_CMD,CBL_CHANGE_ROP_Level_CMD,
+		CBL_GET_SHA256_CMD,CBL_SECTOR_MANIFEST_CMD,CBL_SLOT_INFO_CMD,CBL_GET_TIMING_CMD,CBL_EXEC_RAM_STUB_CMD,CBL_MEM_READ_CMD,CBL_MEM_DUMP_CMD,CBL_BLANK_CHECK_CMD,CBL_BLOCK_DIFF_CMD,CBL_GET_DEVICE_INFO_CMD,CBL_SESSION_OPEN_CMD};
+static const uint32_t BL_Host_Baud_Rates[] = BL_HOST_BAUD_RATES;
+static const BL_Session_t BL_Default_Session = BL_SESSION_DEFAULTS;
+static BL_Session_t BL_Session = BL_SESSION_DEFAULTS;
+static uint8_t BL_Session_State = BL_SESSION_STATE_DEFAULT;
+#ifdef BL_ENABLE_COMPRESSION
+static uint8_t BL_Unpack_Buffer[0xFFU];
+#endif
+/* Running SHA-256 of every payload written by CBL_MEM_WRITE_CMD */
+static BL_SHA256_Ctx_t BL_WriteStream_SHA256;
+static uint8_t BL_WriteStream_Active = 0U;
+static uint32_t BL_WriteStream_Cycles = 0UL;
+/* Last folded frame , a host resending a write whose reply was lost must not be hashed twice.
+ * The frame CRC tells a resend from a new payload written at the same address */
+static uint32_t BL_WriteStream_LastAddress = 0UL;
+static uint32_t BL_WriteStream_LastCRC = 0UL;
+static uint8_t BL_WriteStream_LastLen = 0U;
+#ifdef BL_ENABLE_HOST_TX_DMA
+static DMA_HandleTypeDef BL_Host_Tx_DMA;
+#endif
+static uint32_t BL_SendData_StartCycles = 0UL;
+#ifdef BL_ENABLE_HOST_RX_DMA
+static DMA_HandleTypeDef BL_Host_Rx_DMA;
+static uint8_t BL_Dump_Rx_Ring[BL_DUMP_RX_RING_SIZE];
+static uint32_t BL_Dump_Rx_ReadPos = 0UL;
+#endif
 /* ----------------------- Software Interfaces Start ---------- */
 
 
@@ -57,6 +130,8 @@ BL_Stat_t BL_UART_Featch_Host_Command(void)
 	BL_Stat_t RetStat = BL_ACK;
 	HAL_StatusTypeDef UART_Stat = HAL_OK;
 	uint16_t DataLen = 0;
+	uint32_t ReceiveStartCycles = 0UL;
+	uint8_t SessionState = BL_Session_State;
 	/* Clear Rx Buffer */
 	memset(BL_HOST_BUFFER,(uint8_t)0U , BL_HOST_BUFFER_RX_MAX_SIZE);
 	/*Receive first byte aka number of byte to be received from host
@@ -66,23 +141,42 @@ BL_Stat_t BL_UART_Featch_Host_Command(void)
 #ifdef  BL_ENABLE_DEBUG
 	BL_PrintMsg("Send length of Data %s" , BL_PRINT_NEWLINE);
 #endif
-	UART_Stat |= HAL_UART_Receive(BL_DEBUG_UART, BL_HOST_BUFFER, (uint16_t)1U, HAL_MAX_DELAY);
-	DataLen = BL_HOST_BUFFER[0];
+	/* Only an opened session waits for a limited time , a silent host gets the defaults back */
+	UART_Stat |= HAL_UART_Receive(BL_DEBUG_UART, BL_HOST_BUFFER, (uint16_t)1U,
+								  (BL_SESSION_STATE_DEFAULT == SessionState) ? HAL_MAX_DELAY : BL_SESSION_IDLE_TIMEOUT_MS);
+	if(UART_Stat == HAL_OK)
+	{
+		DataLen = BL_HOST_BUFFER[0];
+		/* Waiting for the host is not counted , the command starts with its length byte */
+		ReceiveStartCycles = BL_TIMING_NOW();
 
 #ifdef  BL_ENABLE_DEBUG
-	BL_PrintMsg("data len = : %i , Send command %s" ,BL_HOST_BUFFER[0] ,BL_PRINT_NEWLINE);
+		BL_PrintMsg("data len = : %i , Send command %s" ,BL_HOST_BUFFER[0] ,BL_PRINT_NEWLINE);
 #endif
-	UART_Stat |= HAL_UART_Receive(BL_DEBUG_UART, BL_HOST_BUFFER+1UL , DataLen, HAL_MAX_DELAY);
-	if(UART_Stat == HAL_OK)
-	{
-		if(IS_BL_COMMAND(BL_HOST_BUFFER[1U]))
+		UART_Stat |= HAL_UART_Receive(BL_DEBUG_UART, BL_HOST_BUFFER+1UL , DataLen, BL_HOST_FRAME_TIMEOUT_MS);
+		if((UART_Stat == HAL_OK) && IS_BL_COMMAND(BL_HOST_BUFFER[1U]))
 		{
+			BL_Timing_Command_Begin(ReceiveStartCycles);
 			BL_HelperFunc[BL_COMMAND_TO_ARR_IDX(BL_HOST_BUFFER[1U])]();
+			BL_Timing_Command_End(BL_COMMAND_TO_ARR_IDX(BL_HOST_BUFFER[1U]));
 		}
-		else
+		else if(UART_Stat == HAL_OK)
 		{
 			RetStat = BL_NACK;
 		}
+		else {/*nothing*/}
+		/* The first frame at the new rate was cut , unknown or failed its CRC : the host did not follow the session */
+		if((BL_SESSION_STATE_PENDING == SessionState) && (BL_SESSION_STATE_PENDING == BL_Session_State) &&
+		   (CBL_SESSION_OPEN_CMD != BL_HOST_BUFFER[1U]))
+		{
+			Bootloader_Session_Close();
+		}
+		else {/*nothing*/}
+	}
+	else
+	{
+		Bootloader_Session_Close();
+		RetStat = BL_NACK;
 	}
 #ifdef  BL_ENABLE_DEBUG
 	BL_PrintMsg("BL_UART_Featch_Host_Command: return status -> %i %s" ,RetStat,BL_PRINT_NEWLINE);
@@ -129,11 +223,30 @@ static uint8_t Bootloader_CRC_Verifiy(uint32_t dataLen ,uint32_t HostCRC)
 	uint32_t MCU_CRC_Calculated = 0;
 	uint8_t DataCounter = 0;
 	uint32_t DataBuffer = 0;
+	uint32_t StartCycles = BL_TIMING_NOW();
 	/*Calculate my CRC*/
-	for( ; DataCounter < dataLen ; ++DataCounter)
+	if((BL_SESSION_CRC_WORD == BL_Session.CRCMode) && (CBL_SESSION_OPEN_CMD != BL_HOST_BUFFER[1U]))
 	{
-		DataBuffer = (uint32_t)BL_HOST_BUFFER[DataCounter];
-		MCU_CRC_Calculated = HAL_CRC_Accumulate(BL_CRC_ENGINE_OBJ , &DataBuffer , (uint32_t)1);
+		/* Session word CRC : a quarter of the engine writes , session open keeps the byte CRC so any host can reopen */
+		for( ; (uint32_t)(DataCounter + 4U) <= dataLen ; DataCounter += 4U)
+		{
+			BL_CRC_ENGINE_OBJ->Instance->DR = __UNALIGNED_UINT32_READ(&BL_HOST_BUFFER[DataCounter]);
+		}
+		if(DataCounter < dataLen)
+		{
+			memcpy(&DataBuffer , &BL_HOST_BUFFER[DataCounter] , dataLen - DataCounter);
+			BL_CRC_ENGINE_OBJ->Instance->DR = DataBuffer;
+		}
+		else {/*nothing*/}
+		MCU_CRC_Calculated = BL_CRC_ENGINE_OBJ->Instance->DR;
+	}
+	else
+	{
+		for( ; DataCounter < dataLen ; ++DataCounter)
+		{
+			DataBuffer = (uint32_t)BL_HOST_BUFFER[DataCounter];
+			MCU_CRC_Calculated = HAL_CRC_Accumulate(BL_CRC_ENGINE_OBJ , &DataBuffer , (uint32_t)1);
+		}
 	}
 
 	/*Reset CRC data REG*/
@@ -142,13 +255,27 @@ static uint8_t Bootloader_CRC_Verifiy(uint32_t dataLen ,uint32_t HostCRC)
 	if(HostCRC == MCU_CRC_Calculated)
 	{
 		crcStat = CRC_VERIFICATION_PASSED;
+		/* A good frame confirms a new session */
+		BL_Session_State = (BL_SESSION_STATE_PENDING == BL_Session_State) ? BL_SESSION_STATE_OPEN : BL_Session_State;
 	}
 	else {}
+	BL_Timing_Phase_Add(BL_TIMING_PHASE_CRC , StartCycles);
 
 	return crcStat;
 }
 
 
+/* Same CRC the host computes over a byte stream : one engine word per byte , caller resets the engine */
+static uint32_t Bootloader_CRC_Accumulate_Bytes(const uint8_t* pData , uint32_t DataLen)
+{
+	uint32_t DataCounter = 0UL;
+	for( ; DataCounter < DataLen ; ++DataCounter)
+	{
+		BL_CRC_ENGINE_OBJ->Instance->DR = (uint32_t)pData[DataCounter];
+	}
+	return BL_CRC_ENGINE_OBJ->Instance->DR;
+}
+
 static void Bootloader_SendAck(uint8_t ReplyMessageLength)
 {
 	uint8_t Ack_Value[CBL_ACK_REPLY_MSG_LENGTH] = {CBL_SEND_ACK , ReplyMessageLength};
@@ -290,6 +417,7 @@ static void Bootloader_Jump_to_Address(void)
 		uint32_t Host_CRC32 = 0UL;
 		pJumpAddressFunc pJumpAddress = NULL;
 		uint32_t HostJumpAdress = 0;
+		uint32_t ImageBase = 0UL;
 		uint8_t Address_Verification = ADDRESS_IS_INVALID;
 		/*extract CRC from buffer */
 		Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
@@ -306,6 +434,13 @@ static void Bootloader_Jump_to_Address(void)
 
 				/* Address Verification */
 			Address_Verification = Bootloader_Host_Jump_Address_verification(HostJumpAdress);
+			if( (ADDRESS_IS_VALID == Address_Verification) && BL_Boot_Is_Image_Base(HostJumpAdress) )
+			{
+				/* Application base is a vector table not code : validated before the reply , the image there must be the one the selection starts */
+				ImageBase = BL_Boot_Select_Image_At(HostJumpAdress);
+				Address_Verification = (0UL != ImageBase) ? ADDRESS_IS_VALID : ADDRESS_IS_NOT_BOOTABLE;
+			}
+			else {/*nothing*/}
 			if ( ADDRESS_IS_VALID == Address_Verification )
 			{
 #ifdef  BL_ENABLE_DEBUG
@@ -317,7 +452,15 @@ static void Bootloader_Jump_to_Address(void)
 			BL_PrintMsg("Jump to : 0x%X  %s" , pJumpAddress , BL_PRINT_NEWLINE);
 #endif
 			BootLoader_SendData( (uint8_t*)(&Address_Verification), (uint32_t)1UL);
-				pJumpAddress();
+				if(0UL != ImageBase)
+				{
+					/* Start the application with a full hand-off */
+					Bootloader_Jump_to_user_main(ImageBase);
+				}
+				else
+				{
+					pJumpAddress();
+				}
 			}
 			else
 			{
@@ -358,14 +501,17 @@ static uint8_t Perfrom_Flash_Erase(uint8_t SectorNum , uint8_t NumberOfSectors)
 	uint8_t FlashEraseStat = BL_INVALID_SECTOR_NUMBER;
 	uint32_t HAL_FLASH_STAT = 0;
 	uint8_t remainingSectors = BL_STM32401_MAX_FLASH_SECTORS - SectorNum;
+	uint8_t LastSector = 0U;
+	uint32_t StartCycles = 0UL;
 	HAL_StatusTypeDef HAL_STAT = HAL_OK;
 	FLASH_EraseInitTypeDef  EraseInit = {
 			.Banks = FLASH_BANK_1,
 			.Sector = (uint32_t)SectorNum,
 			.VoltageRange = FLASH_VOLTAGE_RANGE_3
 	};
-	/*Check if start sector number and number of sectors are valid */
-	if(((BL_STM32401_MAX_FLASH_SECTORS-1U) >= SectorNum || BL_FLASH_MASS_ERASE == SectorNum) )
+	/* Sectors 0..2 hold the bootloader and sector 3 the manifest : application sectors only , at least one */
+	if((BL_MANIFEST_FIRST_APP_SECTOR <= SectorNum) && ((BL_STM32401_MAX_FLASH_SECTORS-1U) >= SectorNum) &&
+			(0U != NumberOfSectors))
 	{
 		/* Check if SectorNumber  + number of sectors to be erased is valid if not valid erase from start sector to last  sector */
 		if(NumberOfSectors >  remainingSectors)
@@ -376,25 +522,28 @@ static uint8_t Perfrom_Flash_Erase(uint8_t SectorNum , uint8_t NumberOfSectors)
 		{
 			EraseInit.NbSectors = (uint32_t)NumberOfSectors;
 		}
-		/*	Erase Flash sector or mass erase */
-		if(BL_FLASH_MASS_ERASE == SectorNum)
+		/* Sector erase */
+		EraseInit.TypeErase = FLASH_TYPEERASE_SECTORS;
+		LastSector = (uint8_t)(SectorNum + EraseInit.NbSectors - 1U);
+		/* Never erase the slot the bootloader started */
+		if(!BL_Boot_Is_Region_Writable(BL_Flash_Sector_Base(SectorNum) ,
+				(BL_Flash_Sector_Base(LastSector) + BL_Flash_Sector_Size(LastSector)) - BL_Flash_Sector_Base(SectorNum)))
 		{
-			/*Mass erase*/
-			EraseInit.TypeErase = FLASH_TYPEERASE_MASSERASE;
-		}
-		else
-		{
-			/* Sector erase */
-			EraseInit.TypeErase = FLASH_TYPEERASE_SECTORS;
+			return BL_INVALID_SECTOR_NUMBER;
 		}
+		else {/*nothing*/}
 #ifdef  BL_ENABLE_DEBUG
 		BL_PrintMsg("Start Erasing Flash %s" , BL_PRINT_NEWLINE);
 #endif
+		StartCycles = BL_TIMING_NOW();
 		/*UnLock Flash*/
 		HAL_STAT |= HAL_FLASH_Unlock();
 		/*	Start flash erase */
 		HAL_STAT |= HAL_FLASHEx_Erase(&EraseInit , &HAL_FLASH_STAT);
 
+		/* Erased sectors no longer match the manifest */
+		BL_Manifest_Mark_Sectors_Erased(SectorNum , (uint8_t)((LastSector - SectorNum) + 1U));
+		BL_Boot_Invalidate_Validation_Cache();
 		/* Check if Flash Erase Success */
 		if(BL_HAL_SUCCESSFUL_ERASE == HAL_FLASH_STAT && HAL_OK == HAL_STAT)
 		{
@@ -406,6 +555,7 @@ static uint8_t Perfrom_Flash_Erase(uint8_t SectorNum , uint8_t NumberOfSectors)
 		}
 		/*Lock Flash*/
 		HAL_STAT |= HAL_FLASH_Lock();
+		BL_Timing_Phase_Add(BL_TIMING_PHASE_FLASH , StartCycles);
 	}
 	else
 	{
@@ -452,17 +602,65 @@ static void Bootloader_Erase_Flash(void)
 		Bootloader_SendNAck();
 	}
 }
+/* Whole write must fit one region , a range crossing a region boundary is never started */
+static uint8_t Bootloader_Find_Write_Region(uint32_t StartMemAddress , uint32_t DataLen)
+{
+	uint8_t RegionIdx = 0U;
+	for( ; RegionIdx < BL_NUMBER_OF_WRITE_REGIONS ; ++RegionIdx)
+	{
+		if( (0UL != DataLen) && (BL_Write_Regions[RegionIdx].BaseAddress <= StartMemAddress) &&
+			(BL_Write_Regions[RegionIdx].EndAddress >= StartMemAddress) &&
+			((BL_Write_Regions[RegionIdx].EndAddress - StartMemAddress) >= DataLen) )
+		{
+			return RegionIdx;
+		}
+		else {/*nothing*/}
+	}
+	return BL_INVALID_WRITE_REGION;
+}
 static uint8_t Perfrom_Memory_Write(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress)
+{
+	uint8_t WriteStat = BL_FLASH_WRITE_FAILED;
+	uint8_t RegionIdx = Bootloader_Find_Write_Region(StartMemAddress , (uint32_t)DataLen);
+	if(BL_INVALID_WRITE_REGION != RegionIdx)
+	{
+		WriteStat = BL_Write_Regions[RegionIdx].pWriteFunc(pDataBuffer , DataLen , StartMemAddress);
+	}
+	else {/*nothing*/}
+	return WriteStat;
+}
+static uint8_t Perfrom_SRAM_Write(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress)
+{
+	/* At most one frame , a CPU copy finishes before a DMA stream would be set up */
+	memcpy((void*)StartMemAddress , pDataBuffer , DataLen);
+	return BL_FLASH_WRITE_PASSED;
+}
+static uint8_t Perfrom_Flash_Write(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress)
 {
 		HAL_StatusTypeDef HAL_stat = HAL_OK;
 		uint8_t l_dataCounter = 0U;
 		uint8_t WriteStat = BL_FLASH_WRITE_FAILED;
+		uint32_t StartCycles = BL_TIMING_NOW();
+		/* Touched sectors must be re-scanned on next manifest commit */
+		BL_Manifest_Mark_Dirty(StartMemAddress , (uint32_t)DataLen);
+		/* Image changes , cached boot validation no longer holds */
+		BL_Boot_Invalidate_Validation_Cache();
 		/*UnLock Flash*/
 		HAL_stat = HAL_FLASH_Unlock();
-
-		for( ; (l_dataCounter < DataLen) && (HAL_OK == HAL_stat) ; ++l_dataCounter)
+		/* Bytes up to the first word boundary , whole words (x32 parallelism , 2.7V..3.6V) then the tail bytes */
+		while((l_dataCounter < DataLen) && (HAL_OK == HAL_stat))
 		{
-			HAL_stat = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE , (StartMemAddress+l_dataCounter) , pDataBuffer[l_dataCounter]);
+			if( (0UL == ((StartMemAddress + l_dataCounter) & 0x03UL)) && ((DataLen - l_dataCounter) >= 4U) )
+			{
+				HAL_stat = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD , (StartMemAddress + l_dataCounter) ,
+						(uint64_t)__UNALIGNED_UINT32_READ(&pDataBuffer[l_dataCounter]));
+				l_dataCounter += 4U;
+			}
+			else
+			{
+				HAL_stat = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE , (StartMemAddress + l_dataCounter) , pDataBuffer[l_dataCounter]);
+				++l_dataCounter;
+			}
 		}
 		if((HAL_OK == HAL_stat))
 		{
@@ -471,6 +669,7 @@ static uint8_t Perfrom_Memory_Write(uint8_t* pDataBuffer , uint8_t DataLen , uin
 		else{/*nothing*/}
 		/*Lock Flash*/
 		HAL_stat = HAL_FLASH_Lock();
+		BL_Timing_Phase_Add(BL_TIMING_PHASE_FLASH , StartCycles);
 		return WriteStat;
 }
 static void Bootloader_Memory_Write(void)
@@ -481,6 +680,8 @@ static void Bootloader_Memory_Write(void)
 		uint8_t PayloadLen = 0;
 		uint8_t MemoryWriteStat = 0;
 		uint8_t Address_Verification = ADDRESS_IS_INVALID;
+		uint32_t StartCycles = 0UL;
+		uint8_t* pPayload = BL_HOST_BUFFER + 7UL;
 		/*extract CRC from buffer */
 		Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
@@ -495,12 +696,49 @@ static void Bootloader_Memory_Write(void)
 			/* Extract base memory address and payload Len */
 			BaseMemeoryAddress = *((uint32_t*)(&BL_HOST_BUFFER[2U]));
 			PayloadLen  = BL_HOST_BUFFER[6U];
-			/*Verifiy Memeory address access */
-			Address_Verification = Bootloader_Host_Jump_Address_verification(BaseMemeoryAddress);
+			/*Verifiy Memeory address access , whole payload in one writable region */
+			if( (BL_INVALID_WRITE_REGION != Bootloader_Find_Write_Region(BaseMemeoryAddress , (uint32_t)PayloadLen)) &&
+				BL_Boot_Is_Region_Writable(BaseMemeoryAddress , (uint32_t)PayloadLen) )
+			{
+				Address_Verification = ADDRESS_IS_VALID;
+			}
+			else {/*nothing*/}
 			if( ADDRESS_IS_VALID == Address_Verification  )
 			{
+#ifdef BL_ENABLE_COMPRESSION
+				/* Session compression : a frame shorter than its payload carries the payload PackBits encoded */
+				if((BL_SESSION_COMPRESSION_ON == BL_Session.Compression) && ((uint32_t)(Host_PacketLen - 11U) < PayloadLen))
+				{
+					pPayload = Bootloader_Unpack_Payload(BL_HOST_BUFFER + 7UL , (uint32_t)(Host_PacketLen - 11U) , BL_Unpack_Buffer , PayloadLen) ? BL_Unpack_Buffer : NULL;
+				}
+				else {/*nothing*/}
+#endif
 				/* Perfrom Memory write */
-				MemoryWriteStat = Perfrom_Memory_Write((BL_HOST_BUFFER+7UL) , PayloadLen , BaseMemeoryAddress);
+				MemoryWriteStat = (NULL != pPayload) ? Perfrom_Memory_Write(pPayload , PayloadLen , BaseMemeoryAddress) : BL_FLASH_WRITE_FAILED;
+				if(BL_FLASH_WRITE_PASSED == MemoryWriteStat)
+				{
+					/* Fold written payload into the write stream digest */
+					StartCycles = BL_TIMING_NOW();
+					if(0U == BL_WriteStream_Active)
+					{
+						BL_SHA256_Init(&BL_WriteStream_SHA256);
+						BL_WriteStream_Cycles = 0UL;
+						BL_WriteStream_LastLen = 0U;
+						BL_WriteStream_Active = 1U;
+					}
+					else {/*nothing*/}
+					if((BaseMemeoryAddress != BL_WriteStream_LastAddress) || (PayloadLen != BL_WriteStream_LastLen) ||
+					   (Host_CRC32 != BL_WriteStream_LastCRC))
+					{
+						BL_SHA256_Update(&BL_WriteStream_SHA256 , pPayload , PayloadLen);
+						BL_WriteStream_LastAddress = BaseMemeoryAddress;
+						BL_WriteStream_LastLen = PayloadLen;
+						BL_WriteStream_LastCRC = Host_CRC32;
+					}
+					else {/*nothing*/}
+					BL_WriteStream_Cycles += BL_TIMING_NOW() - StartCycles;
+				}
+				else {/*nothing*/}
 				/* Report write operation status */
 				BootLoader_SendData((uint8_t*)(&MemoryWriteStat), (uint32_t)1UL);
 #ifdef  BL_ENABLE_DEBUG
@@ -622,53 +860,1073 @@ static uint8_t BL_Read_Flash_Protection_Level(void)
 
 	 return ((uint8_t)(pOBInit.RDPLevel));
 }
-static void Bootloader_Jump_to_user_main(void)
+static void Bootloader_Get_SHA256(void)
 {
-	HAL_StatusTypeDef HalStat = HAL_OK;
-	/* Value of main stack pointer in our main application*/
-	volatile uint32_t MSP_Val = *((volatile uint32_t*)FLASH_SECTOR2_BASE_ADDRESS);
-	/* Reset handler definiation of our main application address and save it  in pointer to function  */
-	volatile uint32_t ResetHanlderAddress = *((volatile uint32_t*)(FLASH_SECTOR2_BASE_ADDRESS+4UL));
-	pMainApp MainAppFunc = (pMainApp)(ResetHanlderAddress);
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint8_t HashMode = 0U;
+	uint32_t RegionAddress = 0UL;
+	uint32_t RegionLength = 0UL;
+	uint32_t StartCycles = 0UL;
+	BL_SHA256_Ctx_t RegionCtx;
+	/* status + digest + cycles */
+	uint8_t SHA256_Reply[BL_SHA256_REPLY_LENGTH] = {BL_SHA256_REQUEST_INVALID , };
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
-	/*Set main stack pointer to Value of main stack pointer in our main application*/
-	__set_MSP(MSP_Val);
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck((uint8_t)BL_SHA256_REPLY_LENGTH);
+		/* Extract hash mode , region base address and region length */
+		HashMode = BL_HOST_BUFFER[2U];
+		RegionAddress = *((uint32_t*)(&BL_HOST_BUFFER[3U]));
+		RegionLength = *((uint32_t*)(&BL_HOST_BUFFER[7U]));
 
-	/* DeInitialization of Modules*/
-	HalStat |= HAL_CRC_DeInit(BL_CRC_ENGINE_OBJ); 			 	/*	De init CRC*/
+		if(BL_SHA256_MODE_REGION == HashMode)
+		{
+			/* Digests of short regions would give the flash away byte by byte under read out protection */
+			if(OB_RDP_LEVEL_0 != BL_Read_Flash_Protection_Level())
+			{
+				SHA256_Reply[0U] = BL_MEM_READ_RDP_ACTIVE;
+			}
+			/* Whole region must be inside one memory , flash or SRAM , without wrapping around */
+			else if(0U != Bootloader_Is_Readable_Range(RegionAddress , RegionLength))
+			{
+				StartCycles = BL_TIMING_NOW();
+				BL_SHA256_Init(&RegionCtx);
+				BL_SHA256_Update(&RegionCtx , (const uint8_t*)RegionAddress , RegionLength);
+				BL_SHA256_Final(&RegionCtx , &SHA256_Reply[1U]);
+				*((uint32_t*)(&SHA256_Reply[1U + BL_SHA256_DIGEST_SIZE])) = BL_TIMING_NOW() - StartCycles;
+				SHA256_Reply[0U] = BL_SHA256_REQUEST_VALID;
+			}
+			else {/*nothing*/}
+		}
+		else if(BL_SHA256_MODE_WRITE_STREAM == HashMode)
+		{
+			/* Digest of everything written since last request, then restart the stream */
+			if(0U == BL_WriteStream_Active)
+			{
+				BL_SHA256_Init(&BL_WriteStream_SHA256);
+				BL_WriteStream_Cycles = 0UL;
+			}
+			else {/*nothing*/}
+			StartCycles = BL_TIMING_NOW();
+			BL_SHA256_Final(&BL_WriteStream_SHA256 , &SHA256_Reply[1U]);
+			BL_WriteStream_Cycles += BL_TIMING_NOW() - StartCycles;
+			*((uint32_t*)(&SHA256_Reply[1U + BL_SHA256_DIGEST_SIZE])) = BL_WriteStream_Cycles;
+			BL_WriteStream_Active = 0U;
+			SHA256_Reply[0U] = BL_SHA256_REQUEST_VALID;
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("SHA256 cycles -> %lu %s" , *((uint32_t*)(&SHA256_Reply[1U + BL_SHA256_DIGEST_SIZE])) , BL_PRINT_NEWLINE);
+#endif
+		/* Report digest and hashing time */
+		BootLoader_SendData(SHA256_Reply , (uint32_t)BL_SHA256_REPLY_LENGTH);
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static void Bootloader_Sector_Manifest(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint8_t ManifestOp = 0U;
+	uint8_t SectorMask = 0U;
+	uint8_t Idx = 0U;
+	uint8_t SectorStat = BL_MANIFEST_SECTOR_UNKNOWN;
+	uint32_t SectorCRC = 0UL;
+	uint32_t StartCycles = 0UL;
+	/* status + generation + (state + CRC) per application sector */
+	uint8_t Manifest_Reply[BL_MANIFEST_REPLY_LENGTH] = {BL_MANIFEST_REQUEST_INVALID , };
+	uint8_t* pSectorReply = &Manifest_Reply[5U];
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
-	HalStat |= HAL_UART_DeInit(BL_HOST_COMMUNICATION_UART); 	/*	De Init Host communication UART*/
-	HalStat |= HAL_UART_DeInit(BL_DEBUG_UART);					 /*	De init DEBUG UART*/
-	__HAL_RCC_GPIOA_CLK_DISABLE();		/*Disable Clocks */
-	HalStat |= HAL_RCC_DeInit();
-	/*Check if DeInitialization of Modules didnt success */
-	if(HalStat != HAL_OK)
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
 	{
-		Error_Handler();
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck((uint8_t)BL_MANIFEST_REPLY_LENGTH);
+		/* Extract operation and sectors selection (bit 0 -> first application sector) */
+		ManifestOp = BL_HOST_BUFFER[2U];
+		SectorMask = BL_HOST_BUFFER[3U];
+
+		if(BL_MANIFEST_OP_COMMIT == ManifestOp)
+		{
+			StartCycles = BL_TIMING_NOW();
+			Manifest_Reply[0U] = BL_Manifest_Commit();
+			BL_Timing_Phase_Add(BL_TIMING_PHASE_FLASH , StartCycles);
+		}
+		else if((BL_MANIFEST_OP_READ == ManifestOp) || (BL_MANIFEST_OP_VALIDATE == ManifestOp))
+		{
+			Manifest_Reply[0U] = BL_MANIFEST_REQUEST_VALID;
+		}
+		else {/*nothing*/}
+
+		if(BL_MANIFEST_REQUEST_VALID == Manifest_Reply[0U])
+		{
+			*((uint32_t*)(&Manifest_Reply[1U])) = BL_Manifest_Get_Generation();
+			for( ; Idx < BL_MANIFEST_NUMBER_OF_APP_SECTORS ; ++Idx , pSectorReply += 5U)
+			{
+				SectorCRC = 0UL;
+				SectorStat = BL_Manifest_Get_Sector_CRC(Idx + BL_MANIFEST_FIRST_APP_SECTOR , &SectorCRC);
+				/* Only the selected sectors are re-scanned */
+				if((BL_MANIFEST_OP_VALIDATE == ManifestOp) && (SectorMask & (1U << Idx)))
+				{
+					SectorStat = BL_Manifest_Validate_Sector(Idx + BL_MANIFEST_FIRST_APP_SECTOR);
+				}
+				else {/*nothing*/}
+				pSectorReply[0U] = SectorStat;
+				*((uint32_t*)(&pSectorReply[1U])) = SectorCRC;
+			}
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Sector manifest Stat -> %i %s" , Manifest_Reply[0U] , BL_PRINT_NEWLINE);
+#endif
+		/* Report manifest content */
+		BootLoader_SendData(Manifest_Reply , (uint32_t)BL_MANIFEST_REPLY_LENGTH);
 	}
 	else
 	{
-		/*Call User Main Reset Handler Funcation*/
-		MainAppFunc();
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
 	}
 }
+static void Bootloader_Slot_Info(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint8_t SlotOp = 0U;
+	uint8_t Slot = BL_BOOT_SLOT_A;
+	const BL_Image_Header_t* pHeader = NULL;
+	/* status + active slot + (validity + attempts + version + size) per slot */
+	uint8_t Slot_Reply[BL_SLOT_INFO_REPLY_LENGTH] = {BL_SLOT_REQUEST_INVALID , };
+	uint8_t* pSlotReply = &Slot_Reply[2U];
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck((uint8_t)BL_SLOT_INFO_REPLY_LENGTH);
+		SlotOp = BL_HOST_BUFFER[2U];
+		if(BL_SLOT_OP_CLEAR_ATTEMPTS == SlotOp)
+		{
+			BL_Boot_Clear_Boot_Attempts();
+			Slot_Reply[0U] = BL_SLOT_REQUEST_VALID;
+		}
+		else if(BL_SLOT_OP_READ == SlotOp)
+		{
+			Slot_Reply[0U] = BL_SLOT_REQUEST_VALID;
+		}
+		else {/*nothing*/}
 
-static void BootLoader_SendData(uint8_t* pData , uint32_t DataLen)
+		if(BL_SLOT_REQUEST_VALID == Slot_Reply[0U])
+		{
+			Slot_Reply[1U] = BL_Boot_Get_Active_Slot();
+			for( ; Slot < BL_BOOT_NUMBER_OF_SLOTS ; ++Slot , pSlotReply += 10U)
+			{
+				pHeader = BL_Boot_Get_Image_Header(BL_Boot_Slot_Base(Slot));
+				pSlotReply[0U] = BL_Boot_Validate_Slot(Slot);
+				pSlotReply[1U] = BL_Boot_Get_Slot_Attempts(Slot);
+				*((uint32_t*)(&pSlotReply[2U])) = (NULL != pHeader) ? pHeader->FwVersion : 0UL;
+				*((uint32_t*)(&pSlotReply[6U])) = (NULL != pHeader) ? pHeader->ImageSize : 0UL;
+			}
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Slot info Stat -> %i %s" , Slot_Reply[0U] , BL_PRINT_NEWLINE);
+#endif
+		BootLoader_SendData(Slot_Reply , (uint32_t)BL_SLOT_INFO_REPLY_LENGTH);
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static void Bootloader_Get_Timing(void)
 {
-	HAL_StatusTypeDef HalStat = HAL_ERROR;
-#if  BL_ENABLE_UART_DEBUG_MSG == BL_DEBUG_METHOD
-		/*Transmit msg using uart */
-		HalStat = HAL_UART_Transmit(BL_DEBUG_UART , pData , DataLen , HAL_MAX_DELAY);
-#elif  BL_ENABLE_SPI_DEBUG_MSG == BL_DEBUG_METHOD
-		/*Transmit msg using spi */
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint8_t ReportedCommand = 0U;
+	const BL_Timing_Command_t* pTiming = NULL;
+	/* status + boot timestamps + decision cycles + command timing */
+	uint8_t Timing_Reply[BL_TIMING_REPLY_LENGTH] = {BL_TIMING_REQUEST_INVALID , };
+	uint8_t* pCommandReply = &Timing_Reply[1U + (BL_BOOT_NUMBER_OF_TIMESTAMPS * 4U) + 4U];
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
-#elif  BL_ENABLE_CAN_DEBUG_MSG == BL_DEBUG_METHOD
-		/*Transmit msg using can*/
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck((uint8_t)BL_TIMING_REPLY_LENGTH);
+		/* Command code whose last dispatch is reported */
+		ReportedCommand = BL_HOST_BUFFER[2U];
+		if(IS_BL_COMMAND(ReportedCommand))
+		{
+			memcpy(&Timing_Reply[1U] , BL_Boot_Shared.BootTimestamps , BL_BOOT_NUMBER_OF_TIMESTAMPS * 4U);
+			*((uint32_t*)(&Timing_Reply[1U + (BL_BOOT_NUMBER_OF_TIMESTAMPS * 4U)])) = BL_Boot_Shared.DecisionCycles;
+			pTiming = BL_Timing_Get_Command(BL_COMMAND_TO_ARR_IDX(ReportedCommand));
+			memcpy(pCommandReply , pTiming , sizeof(BL_Timing_Command_t));
+			Timing_Reply[0U] = BL_TIMING_REQUEST_VALID;
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Timing Stat -> %i %s" , Timing_Reply[0U] , BL_PRINT_NEWLINE);
+#endif
+		BootLoader_SendData(Timing_Reply , (uint32_t)BL_TIMING_REPLY_LENGTH);
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static void Bootloader_Exec_RAM_Stub(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint32_t StubBase = 0UL;
+	uint32_t StubArg = 0UL;
+	BL_Stub_Api_t StubApi = {
+			.ApiVersion = BL_STUB_API_VERSION,
+			.pHostUart = BL_HOST_COMMUNICATION_UART,
+			.pCrc = BL_CRC_ENGINE_OBJ,
+			.pfnMemoryWrite = Perfrom_Memory_Write,
+			.pfnFlashErase = Perfrom_Flash_Erase
+	};
+	/* stub status + stub return value */
+	uint8_t Stub_Reply[BL_STUB_REPLY_LENGTH] = {BL_STUB_INVALID , };
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
+
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length , the stub may talk to the host before the reply is sent */
+		Bootloader_SendAck((uint8_t)BL_STUB_REPLY_LENGTH);
+		/* Extract stub base address and stub argument */
+		StubBase = *((uint32_t*)(&BL_HOST_BUFFER[2U]));
+		StubArg = *((uint32_t*)(&BL_HOST_BUFFER[6U]));
+		if(BL_STUB_VALID == BL_Stub_Validate(StubBase))
+		{
+			StubApi.CoreClockHz = SystemCoreClock;
+			*((uint32_t*)(&Stub_Reply[1U])) = BL_Stub_Call(StubBase , &StubApi , StubArg);
+			Stub_Reply[0U] = BL_STUB_VALID;
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("RAM stub Stat -> %i %s" , Stub_Reply[0U] , BL_PRINT_NEWLINE);
+#endif
+		BootLoader_SendData(Stub_Reply , (uint32_t)BL_STUB_REPLY_LENGTH);
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
 #endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static void Bootloader_Memory_Read(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint32_t ReadAddress = 0UL;
+	uint8_t ReadLen = 0U;
+	uint8_t ReadStat = BL_MEM_READ_INVALID_ADDRESS;
+	uint32_t ReplyCRC = 0UL;
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
-	/*to remove compiler warning*/
-	UNUSED(HalStat);
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/* Extract start address and length */
+		ReadAddress = *((uint32_t*)(&BL_HOST_BUFFER[2U]));
+		ReadLen = BL_HOST_BUFFER[6U];
+		/* Bootloader must not become a way around read out protection */
+		if(OB_RDP_LEVEL_0 != BL_Read_Flash_Protection_Level())
+		{
+			ReadStat = BL_MEM_READ_RDP_ACTIVE;
+		}
+		else if((ReadLen <= BL_MEM_READ_MAX_LENGTH) && Bootloader_Is_Readable_Range(ReadAddress , (uint32_t)ReadLen))
+		{
+			ReadStat = BL_MEM_READ_PASSED;
+		}
+		else {/*nothing*/}
+		/*Send Ack +  Reply message length , status only when the read is refused */
+		Bootloader_SendAck((BL_MEM_READ_PASSED == ReadStat) ? (uint8_t)(1U + ReadLen + CRC_TYPE_SIZE) : (uint8_t)1U);
+		BootLoader_SendData(&ReadStat , 1UL);
+		if(BL_MEM_READ_PASSED == ReadStat)
+		{
+			/* Data leaves straight from memory while the CRC of status + data is calculated */
+			BootLoader_SendData_Start((const uint8_t*)ReadAddress , (uint32_t)ReadLen);
+			__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+			(void)Bootloader_CRC_Accumulate_Bytes(&ReadStat , 1UL);
+			ReplyCRC = Bootloader_CRC_Accumulate_Bytes((const uint8_t*)ReadAddress , (uint32_t)ReadLen);
+			__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+			BootLoader_SendData_Wait();
+			BootLoader_SendData((uint8_t*)(&ReplyCRC) , CRC_TYPE_SIZE);
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Memory read Stat -> %i %s" , ReadStat , BL_PRINT_NEWLINE);
+#endif
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static void Bootloader_Memory_Dump(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint32_t DumpAddress = 0UL;
+	uint32_t DumpLen = 0UL;
+	uint8_t Window = 0U;
+	uint8_t DumpReply[BL_DUMP_REPLY_LENGTH] = {BL_MEM_READ_INVALID_ADDRESS , (uint8_t)BL_DUMP_BLOCK_SIZE , (uint8_t)(BL_DUMP_BLOCK_SIZE >> 8U) , 0U};
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
 
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/* Extract start address , length and requested window */
+		DumpAddress = *((uint32_t*)(&BL_HOST_BUFFER[2U]));
+		DumpLen = *((uint32_t*)(&BL_HOST_BUFFER[6U]));
+		Window = BL_HOST_BUFFER[10U];
+		if(Window > BL_Session.Window)
+		{
+			Window = BL_Session.Window;
+		}
+		else {/*nothing*/}
+		if(OB_RDP_LEVEL_0 != BL_Read_Flash_Protection_Level())
+		{
+			DumpReply[0U] = BL_MEM_READ_RDP_ACTIVE;
+		}
+		else if((0U != Window) && Bootloader_Is_Readable_Range(DumpAddress , DumpLen))
+		{
+			DumpReply[0U] = BL_MEM_READ_PASSED;
+			DumpReply[3U] = Window;
+		}
+		else {/*nothing*/}
+		Bootloader_SendAck(BL_DUMP_REPLY_LENGTH);
+		BootLoader_SendData(DumpReply , BL_DUMP_REPLY_LENGTH);
+		if(BL_MEM_READ_PASSED == DumpReply[0U])
+		{
+			Bootloader_Dump_Stream(DumpAddress , DumpLen , Window);
+		}
+		else {/*nothing*/}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Memory dump Stat -> %i %s" , DumpReply[0U] , BL_PRINT_NEWLINE);
+#endif
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+/*
+ * Sends blocks until the window is full without waiting for the host.
+ * The host acknowledges cumulatively (number of blocks received in order) and
+ * can ask for one block again , a quiet host gets the oldest unacknowledged block again.
+ * */
+static void Bootloader_Dump_Stream(uint32_t DumpAddress , uint32_t DumpLen , uint8_t Window)
+{
+	uint16_t NumberOfBlocks = (uint16_t)((DumpLen + (BL_DUMP_BLOCK_SIZE - 1UL)) / BL_DUMP_BLOCK_SIZE);
+	uint16_t NextBlock = 0U;
+	uint16_t AckedBlocks = 0U;
+	uint16_t CtrlBlock = 0U;
+	uint8_t CtrlFrame[BL_DUMP_CTRL_FRAME_LENGTH];
+	uint8_t Retries = 0U;
+	uint32_t LastProgressTick = HAL_GetTick();
+
+	Bootloader_Dump_Rx_Start();
+	while((AckedBlocks < NumberOfBlocks) && (Retries <= BL_DUMP_MAX_RETRIES))
+	{
+		if((NextBlock < NumberOfBlocks) && ((uint16_t)(NextBlock - AckedBlocks) < Window))
+		{
+			Bootloader_Dump_Send_Block(DumpAddress , DumpLen , NextBlock);
+			++NextBlock;
+		}
+		else if((HAL_GetTick() - LastProgressTick) > BL_DUMP_ACK_TIMEOUT_MS)
+		{
+			Bootloader_Dump_Send_Block(DumpAddress , DumpLen , AckedBlocks);
+			++Retries;
+			LastProgressTick = HAL_GetTick();
+		}
+		else {/*nothing*/}
+
+		if(Bootloader_Dump_Rx_Frame(CtrlFrame))
+		{
+			CtrlBlock = (uint16_t)(CtrlFrame[1U] | ((uint16_t)CtrlFrame[2U] << 8U));
+			if((BL_DUMP_CTRL_ACK == CtrlFrame[0U]) && (CtrlBlock > AckedBlocks) && (CtrlBlock <= NextBlock))
+			{
+				AckedBlocks = CtrlBlock;
+				Retries = 0U;
+				LastProgressTick = HAL_GetTick();
+			}
+			else if((BL_DUMP_CTRL_RETRANSMIT == CtrlFrame[0U]) && (CtrlBlock < NextBlock))
+			{
+				Bootloader_Dump_Send_Block(DumpAddress , DumpLen , CtrlBlock);
+				LastProgressTick = HAL_GetTick();
+			}
+			else if(BL_DUMP_CTRL_ABORT == CtrlFrame[0U])
+			{
+				AckedBlocks = NumberOfBlocks;
+			}
+			else {/*nothing*/}
+		}
+		else {/*nothing*/}
+	}
+	Bootloader_Dump_Rx_Stop();
+}
+/* Block : index (2 bytes) + data + CRC of index and data */
+static void Bootloader_Dump_Send_Block(uint32_t DumpAddress , uint32_t DumpLen , uint16_t BlockIndex)
+{
+	uint32_t BlockOffset = (uint32_t)BlockIndex * BL_DUMP_BLOCK_SIZE;
+	uint32_t BlockLen = DumpLen - BlockOffset;
+	uint8_t BlockHeader[2U] = {(uint8_t)BlockIndex , (uint8_t)(BlockIndex >> 8U)};
+	uint32_t BlockCRC = 0UL;
+	if(BlockLen > BL_DUMP_BLOCK_SIZE)
+	{
+		BlockLen = BL_DUMP_BLOCK_SIZE;
+	}
+	else {/*nothing*/}
+	BootLoader_SendData(BlockHeader , 2UL);
+	BootLoader_SendData_Start((const uint8_t*)(DumpAddress + BlockOffset) , BlockLen);
+	__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+	(void)Bootloader_CRC_Accumulate_Bytes(BlockHeader , 2UL);
+	BlockCRC = Bootloader_CRC_Accumulate_Bytes((const uint8_t*)(DumpAddress + BlockOffset) , BlockLen);
+	__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+	BootLoader_SendData_Wait();
+	BootLoader_SendData((uint8_t*)(&BlockCRC) , CRC_TYPE_SIZE);
+}
+static void Bootloader_Dump_Rx_Start(void)
+{
+#ifdef BL_ENABLE_HOST_RX_DMA
+	if(HAL_DMA_STATE_RESET == BL_Host_Rx_DMA.State)
+	{
+		BL_HOST_RX_DMA_CLK_ENABLE();
+		BL_Host_Rx_DMA.Instance = BL_HOST_RX_DMA_STREAM;
+		BL_Host_Rx_DMA.Init.Channel = BL_HOST_RX_DMA_CHANNEL;
+		BL_Host_Rx_DMA.Init.Direction = DMA_PERIPH_TO_MEMORY;
+		BL_Host_Rx_DMA.Init.PeriphInc = DMA_PINC_DISABLE;
+		BL_Host_Rx_DMA.Init.MemInc = DMA_MINC_ENABLE;
+		BL_Host_Rx_DMA.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		BL_Host_Rx_DMA.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+		BL_Host_Rx_DMA.Init.Mode = DMA_CIRCULAR;
+		BL_Host_Rx_DMA.Init.Priority = DMA_PRIORITY_VERY_HIGH;
+		BL_Host_Rx_DMA.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+		(void)HAL_DMA_Init(&BL_Host_Rx_DMA);
+	}
+	else {/*nothing*/}
+	BL_Dump_Rx_ReadPos = 0UL;
+	__HAL_UART_CLEAR_OREFLAG(BL_HOST_COMMUNICATION_UART);
+	(void)HAL_DMA_Start(&BL_Host_Rx_DMA , (uint32_t)(&(BL_HOST_COMMUNICATION_UART->Instance->DR)) , (uint32_t)BL_Dump_Rx_Ring , BL_DUMP_RX_RING_SIZE);
+	SET_BIT(BL_HOST_COMMUNICATION_UART->Instance->CR3 , USART_CR3_DMAR);
+#endif
+}
+static void Bootloader_Dump_Rx_Stop(void)
+{
+#ifdef BL_ENABLE_HOST_RX_DMA
+	CLEAR_BIT(BL_HOST_COMMUNICATION_UART->Instance->CR3 , USART_CR3_DMAR);
+	(void)HAL_DMA_Abort(&BL_Host_Rx_DMA);
+	__HAL_UART_CLEAR_OREFLAG(BL_HOST_COMMUNICATION_UART);
+#endif
+}
+/* Returns 1 when a control frame with a valid CRC was taken into pFrame */
+static uint8_t Bootloader_Dump_Rx_Frame(uint8_t* pFrame)
+{
+	uint8_t FrameStat = 0U;
+	uint32_t FrameCRC = 0UL;
+#ifdef BL_ENABLE_HOST_RX_DMA
+	uint32_t WritePos = (BL_DUMP_RX_RING_SIZE - __HAL_DMA_GET_COUNTER(&BL_Host_Rx_DMA)) % BL_DUMP_RX_RING_SIZE;
+	uint32_t Available = (WritePos + BL_DUMP_RX_RING_SIZE - BL_Dump_Rx_ReadPos) % BL_DUMP_RX_RING_SIZE;
+	uint8_t ByteCounter = 0U;
+	while((0U == FrameStat) && (Available >= BL_DUMP_CTRL_FRAME_LENGTH))
+	{
+		for(ByteCounter = 0U ; ByteCounter < BL_DUMP_CTRL_FRAME_LENGTH ; ++ByteCounter)
+		{
+			pFrame[ByteCounter] = BL_Dump_Rx_Ring[(BL_Dump_Rx_ReadPos + ByteCounter) % BL_DUMP_RX_RING_SIZE];
+		}
+		__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+		FrameCRC = Bootloader_CRC_Accumulate_Bytes(pFrame , BL_DUMP_CTRL_FRAME_LENGTH - CRC_TYPE_SIZE);
+		__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+		if(FrameCRC == __UNALIGNED_UINT32_READ(&pFrame[BL_DUMP_CTRL_FRAME_LENGTH - CRC_TYPE_SIZE]))
+		{
+			BL_Dump_Rx_ReadPos = (BL_Dump_Rx_ReadPos + BL_DUMP_CTRL_FRAME_LENGTH) % BL_DUMP_RX_RING_SIZE;
+			FrameStat = 1U;
+		}
+		else
+		{
+			/* Resynchronise one byte at a time */
+			BL_Dump_Rx_ReadPos = (BL_Dump_Rx_ReadPos + 1UL) % BL_DUMP_RX_RING_SIZE;
+			--Available;
+		}
+	}
+#else
+	if(HAL_OK == HAL_UART_Receive(BL_HOST_COMMUNICATION_UART , pFrame , (uint16_t)BL_DUMP_CTRL_FRAME_LENGTH , BL_DUMP_ACK_TIMEOUT_MS))
+	{
+		__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+		FrameCRC = Bootloader_CRC_Accumulate_Bytes(pFrame , BL_DUMP_CTRL_FRAME_LENGTH - CRC_TYPE_SIZE);
+		__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+		FrameStat = (FrameCRC == __UNALIGNED_UINT32_READ(&pFrame[BL_DUMP_CTRL_FRAME_LENGTH - CRC_TYPE_SIZE])) ? 1U : 0U;
+	}
+	else {/*nothing*/}
+#endif
+	return FrameStat;
+}
+static void Bootloader_Blank_Check(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint32_t CheckAddress = 0UL;
+	uint32_t CheckLen = 0UL;
+	uint32_t NonBlankOffset = 0UL;
+	uint8_t BlankReply[BL_BLANK_CHECK_REPLY_LENGTH] = {BL_BLANK_CHECK_INVALID_ADDRESS , 0U , 0U , 0U , 0U};
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
+
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck(BL_BLANK_CHECK_REPLY_LENGTH);
+		/* Extract start address and length */
+		CheckAddress = *((uint32_t*)(&BL_HOST_BUFFER[2U]));
+		CheckLen = *((uint32_t*)(&BL_HOST_BUFFER[6U]));
+		/* Only flash is erased to 0xFF , the scan never leaves it */
+		if((0UL != CheckLen) && (FLASH_BASE <= CheckAddress) && (CheckAddress < BL_STM32401_FLASH_END) && ((BL_STM32401_FLASH_END - CheckAddress) >= CheckLen))
+		{
+			NonBlankOffset = Bootloader_Find_Non_Blank(CheckAddress , CheckLen);
+			BlankReply[0U] = (NonBlankOffset == CheckLen) ? BL_BLANK_CHECK_BLANK : BL_BLANK_CHECK_NOT_BLANK;
+			*((uint32_t*)(&BlankReply[1U])) = NonBlankOffset;
+		}
+		else {/*nothing*/}
+		BootLoader_SendData(BlankReply , BL_BLANK_CHECK_REPLY_LENGTH);
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Blank check Stat -> %i %s" , BlankReply[0U] , BL_PRINT_NEWLINE);
+#endif
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+/* Offset of the first byte that is not 0xFF , DataLen when the whole range is erased */
+static uint32_t Bootloader_Find_Non_Blank(uint32_t Address , uint32_t DataLen)
+{
+	uint32_t Offset = 0UL;
+	uint32_t Word = BL_FLASH_ERASED_WORD;
+	/* Bytes up to the first word boundary */
+	for( ; (Offset < DataLen) && (0UL != ((Address + Offset) & 3UL)) ; ++Offset)
+	{
+		if(0xFFU != *((const uint8_t*)(Address + Offset)))
+		{
+			return Offset;
+		}
+		else {/*nothing*/}
+	}
+	/* Four words per loop , AND them so the common (blank) case needs a single compare */
+	for( ; (DataLen - Offset) >= 16UL ; Offset += 16UL)
+	{
+		Word = ((const uint32_t*)(Address + Offset))[0U] & ((const uint32_t*)(Address + Offset))[1U] &
+			   ((const uint32_t*)(Address + Offset))[2U] & ((const uint32_t*)(Address + Offset))[3U];
+		if(BL_FLASH_ERASED_WORD != Word)
+		{
+			break;
+		}
+		else {/*nothing*/}
+	}
+	for( ; (DataLen - Offset) >= 4UL ; Offset += 4UL)
+	{
+		Word = *((const uint32_t*)(Address + Offset));
+		if(BL_FLASH_ERASED_WORD != Word)
+		{
+			/* Little endian : lowest programmed byte = trailing zero bits of the inverted word */
+			return Offset + (__CLZ(__RBIT(~Word)) >> 3U);
+		}
+		else {/*nothing*/}
+	}
+	for( ; Offset < DataLen ; ++Offset)
+	{
+		if(0xFFU != *((const uint8_t*)(Address + Offset)))
+		{
+			break;
+		}
+		else {/*nothing*/}
+	}
+	return Offset;
+}
+static void Bootloader_Block_Diff(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint32_t DiffBase = 0UL;
+	uint32_t BlockAddress = 0UL;
+	uint8_t NumberOfPairs = 0U;
+	uint8_t PairCounter = 0U;
+	uint8_t* pPair = NULL;
+	uint8_t DiffReply[BL_DIFF_REPLY_LENGTH] = {BL_DIFF_INVALID_REQUEST};
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
+
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck(BL_DIFF_REPLY_LENGTH);
+		/* Extract base address and number of (block index , CRC) pairs */
+		DiffBase = *((uint32_t*)(&BL_HOST_BUFFER[2U]));
+		NumberOfPairs = BL_HOST_BUFFER[6U];
+		/* Block CRCs are as good as a memory read under read out protection */
+		if(OB_RDP_LEVEL_0 != BL_Read_Flash_Protection_Level())
+		{
+			DiffReply[0U] = BL_MEM_READ_RDP_ACTIVE;
+		}
+		else if((NumberOfPairs <= BL_DIFF_MAX_PAIRS) &&
+		   (Host_PacketLen == (7U + (NumberOfPairs * BL_DIFF_PAIR_SIZE) + CRC_TYPE_SIZE)) &&
+		   (0UL == (DiffBase & 3UL)) && (FLASH_BASE <= DiffBase) && (DiffBase < BL_STM32401_FLASH_END))
+		{
+			DiffReply[0U] = BL_DIFF_PASSED;
+			for( ; PairCounter < NumberOfPairs ; ++PairCounter)
+			{
+				pPair = &BL_HOST_BUFFER[7U + (PairCounter * BL_DIFF_PAIR_SIZE)];
+				BlockAddress = DiffBase + ((uint32_t)(pPair[0U] | ((uint16_t)pPair[1U] << 8U)) * BL_DIFF_BLOCK_SIZE);
+				if(((BL_STM32401_FLASH_END - DiffBase) < BL_DIFF_BLOCK_SIZE) || (BlockAddress > (BL_STM32401_FLASH_END - BL_DIFF_BLOCK_SIZE)))
+				{
+					/* Block leaves the flash , nothing of the answer can be trusted */
+					DiffReply[0U] = BL_DIFF_INVALID_REQUEST;
+					break;
+				}
+				else {/*nothing*/}
+				/* Same word CRC the host computes over its 0xFF padded block */
+				if(__UNALIGNED_UINT32_READ(&pPair[2U]) != HAL_CRC_Calculate(BL_CRC_ENGINE_OBJ , (uint32_t*)BlockAddress , BL_DIFF_BLOCK_SIZE / 4UL))
+				{
+					DiffReply[1U + (PairCounter >> 3U)] |= (uint8_t)(1U << (PairCounter & 7U));
+				}
+				else {/*nothing*/}
+			}
+			__HAL_CRC_DR_RESET(BL_CRC_ENGINE_OBJ);
+		}
+		else {/*nothing*/}
+		BootLoader_SendData(DiffReply , BL_DIFF_REPLY_LENGTH);
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Block diff Stat -> %i %s" , DiffReply[0U] , BL_PRINT_NEWLINE);
+#endif
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static void Bootloader_Get_Device_Info(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	uint8_t Info_Reply[BL_DEVICE_INFO_REPLY_LENGTH] = {CBL_VENDOR_ID , CBL_SW_MAJOR_VERSION , CBL_SW_MINOR_PATCH , CBL_SW_PATCH_VERSION};
+	uint8_t* pInfo = &Info_Reply[4U];
+	uint8_t BaudCounter = 0U;
+	uint32_t ImageBase = 0UL;
+	uint8_t ActiveSlot = BL_BOOT_NO_SLOT;
+	const BL_Image_Header_t* pHeader = NULL;
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
+
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck((uint8_t)BL_DEVICE_INFO_REPLY_LENGTH);
+		*((uint16_t*)(&pInfo[0U])) = (uint16_t)((DBGMCU->IDCODE) & ((uint32_t)0x0007FFUL));
+		pInfo[2U] = BL_Read_Flash_Protection_Level();
+		memcpy(&pInfo[3U] , (const void*)UID_BASE , BL_DEVICE_UID_SIZE);
+		pInfo += 3U + BL_DEVICE_UID_SIZE;
+		*((uint16_t*)(&pInfo[0U])) = *((const uint16_t*)FLASHSIZE_BASE);
+		*((uint16_t*)(&pInfo[2U])) = (uint16_t)BL_MAX_FRAME_SIZE;
+		*((uint32_t*)(&pInfo[4U])) = Bootloader_Feature_Flags();
+		/* Image selected at boot , header of the active slot or of the application */
+		ImageBase = BL_Boot_Get_Selected_Image();
+		ActiveSlot = BL_Boot_Get_Active_Slot();
+#ifdef BL_ENABLE_DUAL_SLOT
+		pHeader = BL_Boot_Get_Image_Header(BL_Boot_Slot_Base((BL_BOOT_NO_SLOT != ActiveSlot) ? ActiveSlot : BL_BOOT_SLOT_A));
+#else
+		pHeader = BL_Boot_Get_Image_Header(BL_APPLICATION_BASE_ADDRESS);
+#endif
+		pInfo[8U] = (0UL != ImageBase) ? BL_IMAGE_VALID : BL_IMAGE_INVALID;
+		pInfo[9U] = ActiveSlot;
+		pInfo[10U] = (NULL != pHeader) ? 1U : 0U;
+		*((uint32_t*)(&pInfo[11U])) = (NULL != pHeader) ? pHeader->FwVersion : 0UL;
+		*((uint32_t*)(&pInfo[15U])) = (NULL != pHeader) ? pHeader->ImageSize : 0UL;
+		*((uint32_t*)(&pInfo[19U])) = (NULL != pHeader) ? pHeader->ImageCRC : 0UL;
+		pInfo += 23U;
+		*pInfo++ = (uint8_t)BL_NUMBER_OF_BAUD_RATES;
+		for( ; BaudCounter < BL_NUMBER_OF_BAUD_RATES ; ++BaudCounter , pInfo += 4U)
+		{
+			*((uint32_t*)pInfo) = BL_Host_Baud_Rates[BaudCounter];
+		}
+		*pInfo++ = (uint8_t)BL_NUMBER_OF_COMMAND;
+		memcpy(pInfo , BL_Commands , BL_NUMBER_OF_COMMAND);
+		BootLoader_SendData(Info_Reply , (uint32_t)BL_DEVICE_INFO_REPLY_LENGTH);
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+static uint32_t Bootloader_Feature_Flags(void)
+{
+	uint32_t Features = 0UL;
+#ifdef BL_ENABLE_DUAL_SLOT
+	Features |= BL_FEATURE_DUAL_SLOT;
+#endif
+#ifdef BL_ENABLE_HOST_TX_DMA
+	Features |= BL_FEATURE_HOST_TX_DMA;
+#endif
+#ifdef BL_ENABLE_HOST_RX_DMA
+	Features |= BL_FEATURE_HOST_RX_DMA;
+#endif
+#ifdef BL_ENABLE_ROP_LEVEL_2
+	Features |= BL_FEATURE_ROP_LEVEL_2;
+#endif
+#ifdef BL_ENABLE_VALIDATION_CACHE
+	Features |= BL_FEATURE_VALIDATION_CACHE;
+#endif
+#ifdef BL_ENABLE_BOOT_STRAP
+	Features |= BL_FEATURE_BOOT_STRAP;
+#endif
+#ifdef BL_ENABLE_WORD_CRC
+	Features |= BL_FEATURE_WORD_CRC;
+#endif
+#ifdef BL_ENABLE_COMPRESSION
+	Features |= BL_FEATURE_COMPRESSION;
+#endif
+	return Features;
+}
+/*
+ * The host proposes , the bootloader answers with what its build accepts.
+ * New parameters apply from the next frame , the baud rate once this reply left the UART.
+ * Anything but the defaults stays pending until a good frame arrives , the first failed frame
+ * or BL_SESSION_IDLE_TIMEOUT_MS of silence closes it again.
+ * */
+static void Bootloader_Session_Open(void)
+{
+	uint16_t Host_PacketLen = BL_HOST_BUFFER[0U] + 1U;
+	uint32_t Host_CRC32 = 0UL;
+	BL_Session_t Proposal = {0U};
+	uint32_t BaudRate = 0UL;
+	uint8_t Session_Reply[BL_SESSION_REPLY_LENGTH] = {BL_SESSION_OPENED};
+	/*extract CRC from buffer */
+	Host_CRC32 = *((uint32_t*)(BL_HOST_BUFFER + (Host_PacketLen - CRC_TYPE_SIZE)));
+
+	/*Calcualte my crc and verify  crc */
+	if(CRC_VERIFICATION_PASSED == Bootloader_CRC_Verifiy((uint32_t)(Host_PacketLen-CRC_TYPE_SIZE) , Host_CRC32) )
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Passed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send Ack +  Reply message length*/
+		Bootloader_SendAck(BL_SESSION_REPLY_LENGTH);
+		Proposal.FrameSize = *((uint16_t*)(&BL_HOST_BUFFER[2U]));
+		Proposal.Window = BL_HOST_BUFFER[4U];
+		Proposal.CRCMode = BL_HOST_BUFFER[5U];
+		Proposal.Compression = BL_HOST_BUFFER[6U];
+		BaudRate = *((uint32_t*)(&BL_HOST_BUFFER[7U]));
+
+		BL_Session.FrameSize = (Proposal.FrameSize > BL_MAX_FRAME_SIZE) ? BL_MAX_FRAME_SIZE :
+							   ((Proposal.FrameSize < BL_SESSION_MIN_FRAME_SIZE) ? BL_SESSION_MIN_FRAME_SIZE : Proposal.FrameSize);
+		BL_Session.Window = (Proposal.Window > BL_SESSION_MAX_WINDOW) ? BL_SESSION_MAX_WINDOW :
+							((0U == Proposal.Window) ? 1U : Proposal.Window);
+#ifdef BL_ENABLE_WORD_CRC
+		BL_Session.CRCMode = (BL_SESSION_CRC_WORD == Proposal.CRCMode) ? BL_SESSION_CRC_WORD : BL_SESSION_CRC_BYTE;
+#else
+		BL_Session.CRCMode = BL_SESSION_CRC_BYTE;
+#endif
+#ifdef BL_ENABLE_COMPRESSION
+		BL_Session.Compression = (BL_SESSION_COMPRESSION_OFF != Proposal.Compression) ? BL_SESSION_COMPRESSION_ON : BL_SESSION_COMPRESSION_OFF;
+#else
+		BL_Session.Compression = BL_SESSION_COMPRESSION_OFF;
+#endif
+		/* Unknown rate keeps the current one */
+		if(0U == Bootloader_Is_Supported_Baud_Rate(BaudRate))
+		{
+			BaudRate = BL_HOST_COMMUNICATION_UART->Init.BaudRate;
+		}
+		else {/*nothing*/}
+		*((uint16_t*)(&Session_Reply[1U])) = BL_Session.FrameSize;
+		Session_Reply[3U] = BL_Session.Window;
+		Session_Reply[4U] = BL_Session.CRCMode;
+		Session_Reply[5U] = BL_Session.Compression;
+		*((uint32_t*)(&Session_Reply[6U])) = BaudRate;
+		/* Blocking transmit returns once the last bit left , safe to change the rate */
+		BootLoader_SendData(Session_Reply , BL_SESSION_REPLY_LENGTH);
+		if(BaudRate != BL_HOST_COMMUNICATION_UART->Init.BaudRate)
+		{
+			BL_HOST_COMMUNICATION_UART->Init.BaudRate = BaudRate;
+			(void)HAL_UART_Init(BL_HOST_COMMUNICATION_UART);
+		}
+		else {/*nothing*/}
+		if((BL_Host_Baud_Rates[0U] == BaudRate) && (BL_Default_Session.FrameSize == BL_Session.FrameSize) &&
+		   (BL_Default_Session.Window == BL_Session.Window) && (BL_Default_Session.CRCMode == BL_Session.CRCMode) &&
+		   (BL_Default_Session.Compression == BL_Session.Compression))
+		{
+			/* Host restored the defaults , nothing to time out */
+			BL_Session_State = BL_SESSION_STATE_DEFAULT;
+		}
+		else
+		{
+			BL_Session_State = BL_SESSION_STATE_PENDING;
+		}
+#ifdef  BL_ENABLE_DEBUG
+		BL_PrintMsg("Session opened , baud rate %lu %s" , BaudRate , BL_PRINT_NEWLINE);
+#endif
+	}
+	else
+	{
+#ifdef  BL_ENABLE_DEBUG
+			BL_PrintMsg("CRC Verification Failed %s" , BL_PRINT_NEWLINE);
+#endif
+		/*Send NACK */
+		Bootloader_SendNAck();
+	}
+}
+/* Back to the protocol of hosts that never open a session , at the rate set by MX_USART2_UART_Init */
+static void Bootloader_Session_Close(void)
+{
+	BL_Session = BL_Default_Session;
+	BL_Session_State = BL_SESSION_STATE_DEFAULT;
+	if(BL_Host_Baud_Rates[0U] != BL_HOST_COMMUNICATION_UART->Init.BaudRate)
+	{
+		BL_HOST_COMMUNICATION_UART->Init.BaudRate = BL_Host_Baud_Rates[0U];
+		(void)HAL_UART_Init(BL_HOST_COMMUNICATION_UART);
+	}
+	else {/*nothing*/}
+}
+static uint8_t Bootloader_Is_Supported_Baud_Rate(uint32_t BaudRate)
+{
+	uint8_t BaudCounter = 0U;
+	uint8_t BaudStat = 0U;
+	for( ; (BaudCounter < BL_NUMBER_OF_BAUD_RATES) && (0U == BaudStat) ; ++BaudCounter)
+	{
+		BaudStat = (BL_Host_Baud_Rates[BaudCounter] == BaudRate) ? 1U : 0U;
+	}
+	return BaudStat;
+}
+#ifdef BL_ENABLE_COMPRESSION
+/*
+ * PackBits : header n <= 127 -> n + 1 literal bytes , header n >= 129 -> next byte repeated 257 - n times.
+ * Returns 1 only when the source decodes to exactly DstLen bytes.
+ * */
+static uint8_t Bootloader_Unpack_Payload(const uint8_t* pSrc , uint32_t SrcLen , uint8_t* pDst , uint8_t DstLen)
+{
+	const uint8_t* pSrcEnd = pSrc + SrcLen;
+	uint32_t DstCounter = 0UL;
+	uint32_t RunLen = 0UL;
+	uint8_t Header = 0U;
+	while(pSrc < pSrcEnd)
+	{
+		Header = *pSrc++;
+		if(Header < 128U)
+		{
+			RunLen = (uint32_t)Header + 1UL;
+			if(((uint32_t)(pSrcEnd - pSrc) < RunLen) || ((DstCounter + RunLen) > DstLen))
+			{
+				return 0U;
+			}
+			else {/*nothing*/}
+			memcpy(&pDst[DstCounter] , pSrc , RunLen);
+			pSrc += RunLen;
+		}
+		else if(Header > 128U)
+		{
+			RunLen = 257UL - (uint32_t)Header;
+			if((pSrc == pSrcEnd) || ((DstCounter + RunLen) > DstLen))
+			{
+				return 0U;
+			}
+			else {/*nothing*/}
+			memset(&pDst[DstCounter] , *pSrc++ , RunLen);
+		}
+		else
+		{
+			RunLen = 0UL;
+		}
+		DstCounter += RunLen;
+	}
+	return (DstCounter == DstLen) ? 1U : 0U;
+}
+#endif
+/* Whole range inside flash or inside SRAM */
+static uint8_t Bootloader_Is_Readable_Range(uint32_t StartMemAddress , uint32_t DataLen)
+{
+	return ( (0UL != DataLen) &&
+			 ( ((FLASH_BASE <= StartMemAddress) && (StartMemAddress < BL_STM32401_FLASH_END) && ((BL_STM32401_FLASH_END - StartMemAddress) >= DataLen)) ||
+			   ((SRAM1_BASE <= StartMemAddress) && (StartMemAddress < BL_STM32F401_SRAM_END) && ((BL_STM32F401_SRAM_END - StartMemAddress) >= DataLen)) ) ) ? 1U : 0U;
+}
+/* ImageBase must come from the image selection , the reply to the host is already sent */
+static void Bootloader_Jump_to_user_main(uint32_t ImageBase)
+{
+	HAL_StatusTypeDef HalStat = HAL_OK;
+
+	BL_Boot_Record_Boot_Attempt();
+	BL_Timing_Boot_Stamp(BL_BOOT_TS_JUMP);
+
+	/* DeInitialization of Modules*/
+	HalStat |= HAL_CRC_DeInit(BL_CRC_ENGINE_OBJ); 			 	/*	De init CRC*/
+
+	HalStat |= HAL_UART_DeInit(BL_HOST_COMMUNICATION_UART); 	/*	De Init Host communication UART*/
+	HalStat |= HAL_UART_DeInit(BL_DEBUG_UART);					 /*	De init DEBUG UART*/
+	__HAL_RCC_GPIOA_CLK_DISABLE();		/*Disable Clocks */
+	/* Back to HSI , needs SysTick for its timeouts so it runs before the core hand-off */
+	HalStat |= HAL_RCC_DeInit();
+	/* Reset every peripheral through RCC */
+	HalStat |= HAL_DeInit();
+	/*Check if DeInitialization of Modules didnt success */
+	if(HalStat != HAL_OK)
+	{
+		Error_Handler();
+	}
+	else
+	{
+		/* SysTick , NVIC , VTOR and stack hand-off , does not return */
+		BL_Boot_Jump_To_Image(ImageBase);
+	}
+}
+
+
+static void BootLoader_SendData(uint8_t* pData , uint32_t DataLen)
+{
+	HAL_StatusTypeDef HalStat = HAL_ERROR;
+	uint32_t StartCycles = BL_TIMING_NOW();
+#if  BL_ENABLE_UART_DEBUG_MSG == BL_DEBUG_METHOD
+		/*Transmit msg using uart */
+		HalStat = HAL_UART_Transmit(BL_DEBUG_UART , pData , DataLen , HAL_MAX_DELAY);
+#elif  BL_ENABLE_SPI_DEBUG_MSG == BL_DEBUG_METHOD
+		/*Transmit msg using spi */
+
+#elif  BL_ENABLE_CAN_DEBUG_MSG == BL_DEBUG_METHOD
+		/*Transmit msg using can*/
+#endif
+	BL_Timing_Phase_Add(BL_TIMING_PHASE_REPLY , StartCycles);
+	/*to remove compiler warning*/
+	UNUSED(HalStat);
+
+}
+/*
+ * Host link transmit that leaves the CPU free until @ref BootLoader_SendData_Wait.
+ * DMA runs in polling mode (no interrupt) and reads the source directly , flash or SRAM.
+ * */
+static void BootLoader_SendData_Start(const uint8_t* pData , uint32_t DataLen)
+{
+	BL_SendData_StartCycles = BL_TIMING_NOW();
+#ifdef BL_ENABLE_HOST_TX_DMA
+	if(HAL_DMA_STATE_RESET == BL_Host_Tx_DMA.State)
+	{
+		BL_HOST_TX_DMA_CLK_ENABLE();
+		BL_Host_Tx_DMA.Instance = BL_HOST_TX_DMA_STREAM;
+		BL_Host_Tx_DMA.Init.Channel = BL_HOST_TX_DMA_CHANNEL;
+		BL_Host_Tx_DMA.Init.Direction = DMA_MEMORY_TO_PERIPH;
+		BL_Host_Tx_DMA.Init.PeriphInc = DMA_PINC_DISABLE;
+		BL_Host_Tx_DMA.Init.MemInc = DMA_MINC_ENABLE;
+		BL_Host_Tx_DMA.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		BL_Host_Tx_DMA.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+		BL_Host_Tx_DMA.Init.Mode = DMA_NORMAL;
+		BL_Host_Tx_DMA.Init.Priority = DMA_PRIORITY_HIGH;
+		BL_Host_Tx_DMA.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+		(void)HAL_DMA_Init(&BL_Host_Tx_DMA);
+	}
+	else {/*nothing*/}
+	__HAL_UART_CLEAR_FLAG(BL_HOST_COMMUNICATION_UART , UART_FLAG_TC);
+	(void)HAL_DMA_Start(&BL_Host_Tx_DMA , (uint32_t)pData , (uint32_t)(&(BL_HOST_COMMUNICATION_UART->Instance->DR)) , DataLen);
+	SET_BIT(BL_HOST_COMMUNICATION_UART->Instance->CR3 , USART_CR3_DMAT);
+#else
+	(void)HAL_UART_Transmit(BL_HOST_COMMUNICATION_UART , (uint8_t*)pData , (uint16_t)DataLen , HAL_MAX_DELAY);
+#endif
+}
+static void BootLoader_SendData_Wait(void)
+{
+#ifdef BL_ENABLE_HOST_TX_DMA
+	(void)HAL_DMA_PollForTransfer(&BL_Host_Tx_DMA , HAL_DMA_FULL_TRANSFER , HAL_MAX_DELAY);
+	CLEAR_BIT(BL_HOST_COMMUNICATION_UART->Instance->CR3 , USART_CR3_DMAT);
+	/* Last byte out of the shift register */
+	while(RESET == __HAL_UART_GET_FLAG(BL_HOST_COMMUNICATION_UART , UART_FLAG_TC));
+#endif
+	BL_Timing_Phase_Add(BL_TIMING_PHASE_REPLY , BL_SendData_StartCycles);
 }
 /*****************************************/
@@ -12,6 +12,11 @@
 #include "usart.h"
 #include "crc.h"
 #include "Bootloader_CFG.h"
+#include "Bootloader_SHA256.h"
+#include "Bootloader_Manifest.h"
+#include "Bootloader_Boot.h"
+#include "Bootloader_Timing.h"
+#include "Bootloader_Stub.h"
 #include "stdio.h"
 #include <strings.h>
 #include <string.h>
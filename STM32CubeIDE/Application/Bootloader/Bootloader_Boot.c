@@ -0,0 +1,552 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Boot.c
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Boot.c
+ ******************************************************************************
+ */
+#include "Bootloader.h"
+#include "Bootloader_private.h"
+#include <stddef.h>
+
+/* ----------------------- MACROS Start ---------------------- */
+#define BL_BOOT_CACHE_MAGIC				(0xB0075AFEUL)
+#define BL_BOOT_COLD_RESET_FLAGS		(RCC_CSR_PORRSTF | RCC_CSR_BORRSTF)
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+#define BL_BOOT_BKP_REG(_IDX)			((&(RTC->BKP0R))[BL_BOOT_BKP_FIRST_REGISTER + (_IDX)])
+/* ----------------------- Macro Function End ----------------- */
+
+static void BL_Boot_Enable_Backup_Access(void);
+static uint8_t BL_Boot_Is_Cold_Reset(void);
+static uint8_t BL_Boot_Strap_Is_Active(void);
+static uint8_t BL_Boot_Vector_Table_Is_Valid(uint32_t ImageBase);
+static uint8_t BL_Boot_Cache_Lookup(uint32_t CacheKey);
+static void BL_Boot_Cache_Record(uint32_t CacheKey , uint8_t ImageStat);
+static uint8_t BL_Boot_Validate_Image(uint32_t RegionBase , uint32_t RegionSize , uint8_t CacheResult);
+static uint8_t BL_Boot_Slot_Is_Rejected(uint8_t Slot);
+#ifdef BL_ENABLE_DUAL_SLOT
+static uint8_t BL_Boot_Newest_Slot(void);
+static void BL_Boot_Reject_Slot(uint8_t Slot);
+#endif
+/* Outcome of the selection in BL_Boot_Early_Decision , kept when the bootloader stays */
+static uint8_t BL_Boot_Active_Slot = BL_BOOT_NO_SLOT;
+static uint32_t BL_Boot_Selected_Image = 0UL;
+
+BL_Boot_Shared_t BL_Boot_Shared __attribute__((section(".bl_shared")));
+
+/* ----------------------- Software Interfaces Start ---------- */
+/*
+ * Runs first thing in main , before HAL_Init and the PLL.
+ * Jumps straight to the application unless a bootloader entry trigger is found :
+ * boot request word in shared RAM , boot strap pin or no valid image to start.
+ * The image is selected on every boot , a bootloader that stays reports and protects that choice.
+ * Returns only when the bootloader has to run.
+ * */
+void BL_Boot_Early_Decision(void)
+{
+	uint32_t StartCycles = 0UL;
+	uint32_t ImageBase = 0UL;
+
+	/* DWT cycle counter from zero , boot timestamps are left in the shared block for the application */
+	BL_Timing_Enable();
+	DWT->CYCCNT = 0UL;
+	BL_Timing_Boot_Stamp(BL_BOOT_TS_RESET);
+	StartCycles = BL_Boot_Shared.BootTimestamps[BL_BOOT_TS_RESET];
+
+	/* CRC engine only , runs on the reset HSI clock */
+	MX_CRC_Init();
+	ImageBase = BL_Boot_Select_Image();
+	(void)HAL_CRC_DeInit(BL_CRC_ENGINE_OBJ);
+	BL_Boot_Selected_Image = ImageBase;
+
+	if(BL_BOOT_REQUEST_MAGIC == BL_Boot_Shared.BootRequest)
+	{
+		/* One shot request */
+		BL_Boot_Shared.BootRequest = 0UL;
+		ImageBase = 0UL;
+	}
+	else if(BL_Boot_Strap_Is_Active())
+	{
+		ImageBase = 0UL;
+	}
+	else {/*nothing*/}
+	BL_Boot_Shared.DecisionCycles = BL_TIMING_NOW() - StartCycles;
+
+	if(0UL != ImageBase)
+	{
+		BL_Boot_Record_Boot_Attempt();
+		BL_Timing_Boot_Stamp(BL_BOOT_TS_JUMP);
+		BL_Boot_Jump_To_Image(ImageBase);
+	}
+	else {/*nothing*/}
+}
+
+/*
+ * Checks every application sector against the manifest.
+ * Warm resets reuse the result recorded for the current manifest generation ,
+ * power on / brown out resets or a changed generation force the full CRC scan.
+ * */
+uint8_t BL_Boot_Validate_Application(void)
+{
+	uint8_t ImageStat = BL_IMAGE_VALID;
+	uint8_t Sector = BL_MANIFEST_FIRST_APP_SECTOR;
+	uint32_t Generation = BL_Manifest_Get_Generation();
+
+	if( (0U == BL_Manifest_Get_Dirty_Mask()) && (BL_IMAGE_VALID == BL_Boot_Cache_Lookup(Generation)) )
+	{
+		return BL_IMAGE_VALID;
+	}
+	else {/*nothing*/}
+	for( ; (Sector < BL_FLASH_NUMBER_OF_SECTORS) && (BL_IMAGE_VALID == ImageStat) ; ++Sector)
+	{
+		if(BL_MANIFEST_SECTOR_MATCH != BL_Manifest_Validate_Sector(Sector))
+		{
+			ImageStat = BL_IMAGE_INVALID;
+		}
+		else {/*nothing*/}
+	}
+	BL_Boot_Cache_Record(Generation , ImageStat);
+	return ImageStat;
+}
+
+/*
+ * Vector table address of the image to start , 0 when nothing is bootable.
+ * Dual slot : newest valid slot first , the other one when it fails validation
+ * or used up its boot attempts without being confirmed by the application.
+ * A slot that used up its attempts is rejected until it holds another image.
+ * */
+uint32_t BL_Boot_Select_Image(void)
+{
+	uint32_t ImageBase = 0UL;
+#ifdef BL_ENABLE_DUAL_SLOT
+	uint8_t Slot = BL_Boot_Newest_Slot();
+	uint8_t Counter = 0U;
+
+	BL_Boot_Active_Slot = BL_BOOT_NO_SLOT;
+	for( ; (Counter < BL_BOOT_NUMBER_OF_SLOTS) && (0UL == ImageBase) ; ++Counter , Slot ^= 0x01U)
+	{
+		if(BL_Boot_Get_Slot_Attempts(Slot) >= BL_BOOT_MAX_ATTEMPTS)
+		{
+			/* The attempt count only follows the slot started last , the failure is kept with the image */
+			BL_Boot_Reject_Slot(Slot);
+		}
+		else if(BL_IMAGE_VALID == BL_Boot_Validate_Slot(Slot))
+		{
+			BL_Boot_Active_Slot = Slot;
+			ImageBase = BL_Boot_Slot_Base(Slot) + BL_IMAGE_HEADER_SIZE;
+		}
+		else {/*nothing*/}
+	}
+#else
+	if(BL_IMAGE_HEADER_MAGIC == ((const BL_Image_Header_t*)BL_APPLICATION_BASE_ADDRESS)->Magic)
+	{
+		/* Stamped image , only the bytes the header covers are checked */
+		if(BL_IMAGE_VALID == BL_Boot_Validate_Image(BL_APPLICATION_BASE_ADDRESS , BL_STM32401_FLASH_END - BL_APPLICATION_BASE_ADDRESS , 1U))
+		{
+			ImageBase = BL_APPLICATION_BASE_ADDRESS + BL_IMAGE_HEADER_SIZE;
+		}
+		else {/*nothing*/}
+	}
+	else if( BL_Boot_Vector_Table_Is_Valid(BL_APPLICATION_BASE_ADDRESS) &&
+			 (BL_IMAGE_VALID == BL_Boot_Validate_Application()) )
+	{
+		ImageBase = BL_APPLICATION_BASE_ADDRESS;
+	}
+	else {/*nothing*/}
+#endif
+	return ImageBase;
+}
+
+/*
+ * Selection for a host request to start the image at RegionBase (slot or application base).
+ * Vector table address when the selection starts that very image , 0 otherwise and
+ * the slot selected at boot stays active.
+ * */
+uint32_t BL_Boot_Select_Image_At(uint32_t RegionBase)
+{
+	uint8_t BootSlot = BL_Boot_Active_Slot;
+	uint32_t ImageBase = BL_Boot_Select_Image();
+
+	if((RegionBase != ImageBase) && ((RegionBase + BL_IMAGE_HEADER_SIZE) != ImageBase))
+	{
+		BL_Boot_Active_Slot = BootSlot;
+		ImageBase = 0UL;
+	}
+	else {/*nothing*/}
+	return ImageBase;
+}
+
+/* Addresses the host may use with CBL_GO_TO_ADDR_CMD to start the application */
+uint8_t BL_Boot_Is_Image_Base(uint32_t Address)
+{
+#ifdef BL_ENABLE_DUAL_SLOT
+	return ((BL_SLOT_A_BASE_ADDRESS == Address) || (BL_SLOT_B_BASE_ADDRESS == Address)) ? 1U : 0U;
+#else
+	return (BL_APPLICATION_BASE_ADDRESS == Address) ? 1U : 0U;
+#endif
+}
+
+/* Counts one more unconfirmed start of the selected slot , call right before the jump */
+void BL_Boot_Record_Boot_Attempt(void)
+{
+#ifdef BL_ENABLE_DUAL_SLOT
+	uint32_t Attempts = 0UL;
+	if(BL_BOOT_NO_SLOT != BL_Boot_Active_Slot)
+	{
+		BL_Boot_Enable_Backup_Access();
+		Attempts = BL_BOOT_BKP_REG(BL_BOOT_BKP_BOOT_ATTEMPTS);
+		if(((Attempts >> 8U) & 0xFFUL) == BL_Boot_Active_Slot)
+		{
+			Attempts = (Attempts & 0xFF00UL) | (((Attempts & 0xFFUL) + 1UL) & 0xFFUL);
+		}
+		else
+		{
+			Attempts = ((uint32_t)BL_Boot_Active_Slot << 8U) | 1UL;
+		}
+		BL_BOOT_BKP_REG(BL_BOOT_BKP_BOOT_ATTEMPTS) = Attempts;
+	}
+	else {/*nothing*/}
+#endif
+}
+
+/* Slot the current boot selected , reading it never selects again */
+uint8_t BL_Boot_Get_Active_Slot(void)
+{
+	return BL_Boot_Active_Slot;
+}
+
+/* Vector table address the current boot selected , 0 when nothing was bootable. Never selects again */
+uint32_t BL_Boot_Get_Selected_Image(void)
+{
+	return BL_Boot_Selected_Image;
+}
+
+uint32_t BL_Boot_Slot_Base(uint8_t Slot)
+{
+	return (BL_BOOT_SLOT_A == Slot) ? BL_SLOT_A_BASE_ADDRESS : BL_SLOT_B_BASE_ADDRESS;
+}
+
+uint32_t BL_Boot_Slot_Size(uint8_t Slot)
+{
+	return (BL_BOOT_SLOT_A == Slot) ? BL_SLOT_A_SIZE : BL_SLOT_B_SIZE;
+}
+
+uint8_t BL_Boot_Validate_Slot(uint8_t Slot)
+{
+	uint8_t CacheResult = 0U;
+#ifdef BL_ENABLE_DUAL_SLOT
+	/* Cache belongs to the slot being started , never to a slot that is only inspected */
+	CacheResult = ((BL_BOOT_NO_SLOT == BL_Boot_Active_Slot) || (BL_Boot_Active_Slot == Slot)) ? 1U : 0U;
+#endif
+	return BL_Boot_Validate_Image(BL_Boot_Slot_Base(Slot) , BL_Boot_Slot_Size(Slot) , CacheResult);
+}
+
+/*
+ * Header at RegionBase when its magic , version and header CRC are right , NULL otherwise.
+ * Needs the CRC engine.
+ * */
+const BL_Image_Header_t* BL_Boot_Get_Image_Header(uint32_t RegionBase)
+{
+	const BL_Image_Header_t* pHeader = (const BL_Image_Header_t*)RegionBase;
+	if( (BL_IMAGE_HEADER_MAGIC != pHeader->Magic) || (BL_IMAGE_HEADER_VERSION != pHeader->HeaderVersion) ||
+		(pHeader->HeaderCRC != HAL_CRC_Calculate(BL_CRC_ENGINE_OBJ , (uint32_t*)RegionBase ,
+				(uint32_t)(offsetof(BL_Image_Header_t , HeaderCRC) / 4U))) )
+	{
+		pHeader = NULL;
+	}
+	else {/*nothing*/}
+	return pHeader;
+}
+
+/* Unconfirmed starts of Slot , BL_BOOT_SLOT_REJECTED once its image used them all up. Needs the CRC engine. */
+uint8_t BL_Boot_Get_Slot_Attempts(uint8_t Slot)
+{
+	uint32_t Attempts = 0UL;
+	if(BL_Boot_Slot_Is_Rejected(Slot))
+	{
+		return BL_BOOT_SLOT_REJECTED;
+	}
+	else {/*nothing*/}
+	BL_Boot_Enable_Backup_Access();
+	Attempts = BL_BOOT_BKP_REG(BL_BOOT_BKP_BOOT_ATTEMPTS);
+	return (((Attempts >> 8U) & 0xFFUL) == Slot) ? (uint8_t)(Attempts & 0xFFUL) : 0U;
+}
+
+/* Host override , unlike the application confirming its boot it also forgets the rejected images */
+void BL_Boot_Clear_Boot_Attempts(void)
+{
+	BL_Boot_Enable_Backup_Access();
+	BL_BOOT_BKP_REG(BL_BOOT_BKP_BOOT_ATTEMPTS) = 0UL;
+	BL_BOOT_BKP_REG(BL_BOOT_BKP_REJECTED_SLOT_A) = 0UL;
+	BL_BOOT_BKP_REG(BL_BOOT_BKP_REJECTED_SLOT_B) = 0UL;
+}
+
+/* Dual slot : the running image stays intact , only the inactive slot may be written or erased */
+uint8_t BL_Boot_Is_Region_Writable(uint32_t Address , uint32_t DataLen)
+{
+	uint8_t Writable = 1U;
+#ifdef BL_ENABLE_DUAL_SLOT
+	uint8_t ActiveSlot = BL_Boot_Get_Active_Slot();
+	uint32_t SlotBase = 0UL;
+	if(BL_BOOT_NO_SLOT != ActiveSlot)
+	{
+		SlotBase = BL_Boot_Slot_Base(ActiveSlot);
+		if( (Address < (SlotBase + BL_Boot_Slot_Size(ActiveSlot))) && ((Address + DataLen) > SlotBase) )
+		{
+			Writable = 0U;
+		}
+		else {/*nothing*/}
+	}
+	else {/*nothing*/}
+#else
+	UNUSED(Address);
+	UNUSED(DataLen);
+#endif
+	return Writable;
+}
+
+void BL_Boot_Invalidate_Validation_Cache(void)
+{
+#ifdef BL_ENABLE_VALIDATION_CACHE
+	BL_Boot_Enable_Backup_Access();
+	BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_MAGIC) = 0UL;
+#endif
+}
+/*
+ * Leaves the core as a reset would : interrupts masked while SysTick is stopped ,
+ * every NVIC line disabled and un-pended , VTOR on the image , privileged thread mode on MSP.
+ * Peripherals and clocks must already be de-initialized by the caller.
+ * */
+void BL_Boot_Jump_To_Image(uint32_t ImageBase)
+{
+	uint32_t MSP_Val = *((volatile uint32_t*)ImageBase);
+	uint32_t ResetHandlerAddress = *((volatile uint32_t*)(ImageBase + 4UL));
+	uint8_t Counter = 0U;
+
+	__disable_irq();
+	/* SysTick back to reset state */
+	SysTick->CTRL = 0UL;
+	SysTick->LOAD = 0UL;
+	SysTick->VAL = 0UL;
+	/* Disable and clear every external interrupt line */
+	for( ; Counter < (sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0U])) ; ++Counter)
+	{
+		NVIC->ICER[Counter] = 0xFFFFFFFFUL;
+		NVIC->ICPR[Counter] = 0xFFFFFFFFUL;
+	}
+	/* Pending SysTick / PendSV and enabled fault handlers */
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk | SCB_ICSR_PENDSVCLR_Msk;
+	SCB->SHCSR &= ~(SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_MEMFAULTENA_Msk);
+	/* Backup domain access was only needed for the validation cache */
+	HAL_PWR_DisableBkUpAccess();
+	__HAL_RCC_PWR_CLK_DISABLE();
+	/* Application vector table , privileged thread mode on MSP with no FP context */
+	SCB->VTOR = ImageBase;
+	__set_CONTROL(0UL);
+	__DSB();
+	__ISB();
+	BL_Boot_Shared.HandoffCycles = BL_TIMING_NOW() - BL_Boot_Shared.BootTimestamps[BL_BOOT_TS_JUMP];
+	/* Stack switch , unmask and branch in one asm block , nothing may touch the old stack in between */
+	__ASM volatile ("MSR  msp, %0\n\t"
+					"CPSIE i\n\t"
+					"BX   %1"
+					: : "r" (MSP_Val) , "r" (ResetHandlerAddress) : "memory");
+}
+/* ----------------------- Software Interfaces end ------------ */
+
+/*Static private functions Declarations*/
+static void BL_Boot_Enable_Backup_Access(void)
+{
+	__HAL_RCC_PWR_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+}
+
+/*
+ * Warm reset and "key X verified" recorded by @ref BL_Boot_Cache_Record.
+ * Power on / brown out resets always miss so a full scan runs at least once per power cycle.
+ * */
+static uint8_t BL_Boot_Cache_Lookup(uint32_t CacheKey)
+{
+	uint8_t ImageStat = BL_IMAGE_INVALID;
+	uint8_t ColdReset = 0U;
+
+	BL_Boot_Enable_Backup_Access();
+	ColdReset = BL_Boot_Is_Cold_Reset();
+#ifdef BL_ENABLE_VALIDATION_CACHE
+	if( (0U == ColdReset) &&
+		(BL_BOOT_CACHE_MAGIC == BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_MAGIC)) &&
+		(CacheKey == BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_KEY)) &&
+		(~CacheKey == BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_CHECK)) )
+	{
+		ImageStat = BL_IMAGE_VALID;
+	}
+	else {/*nothing*/}
+#else
+	UNUSED(ColdReset);
+	UNUSED(CacheKey);
+#endif
+	return ImageStat;
+}
+
+static void BL_Boot_Cache_Record(uint32_t CacheKey , uint8_t ImageStat)
+{
+#ifdef BL_ENABLE_VALIDATION_CACHE
+	if(BL_IMAGE_VALID == ImageStat)
+	{
+		/* Record "key X verified" , check word is written last */
+		BL_Boot_Enable_Backup_Access();
+		BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_MAGIC) = BL_BOOT_CACHE_MAGIC;
+		BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_KEY) = CacheKey;
+		BL_BOOT_BKP_REG(BL_BOOT_BKP_CACHE_CHECK) = ~CacheKey;
+	}
+	else
+	{
+		BL_Boot_Invalidate_Validation_Cache();
+	}
+#else
+	UNUSED(CacheKey);
+	UNUSED(ImageStat);
+#endif
+}
+
+/*
+ * Bootability from the header : version , image linked for this region , size fits ,
+ * entry point inside the image and equal to the vector table reset handler.
+ * Then the CRC over ImageSize bytes only , skipped on a warm reset that already verified it.
+ * */
+static uint8_t BL_Boot_Validate_Image(uint32_t RegionBase , uint32_t RegionSize , uint8_t CacheResult)
+{
+	const BL_Image_Header_t* pHeader = BL_Boot_Get_Image_Header(RegionBase);
+	uint32_t VectorTable = RegionBase + BL_IMAGE_HEADER_SIZE;
+	uint8_t ImageStat = BL_IMAGE_INVALID;
+	uint32_t CacheKey = 0UL;
+
+	if( (NULL == pHeader) || (VectorTable != pHeader->LoadAddress) ||
+		(0UL == pHeader->ImageSize) || (0UL != (pHeader->ImageSize & 0x03UL)) ||
+		(pHeader->ImageSize > (RegionSize - BL_IMAGE_HEADER_SIZE)) ||
+		(pHeader->EntryPoint != *((volatile uint32_t*)(VectorTable + 4UL))) ||
+		((pHeader->EntryPoint & ~0x01UL) >= (VectorTable + pHeader->ImageSize)) ||
+		(!BL_Boot_Vector_Table_Is_Valid(VectorTable)) )
+	{
+		return BL_IMAGE_INVALID;
+	}
+	else {/*nothing*/}
+	CacheKey = pHeader->ImageCRC ^ RegionBase;
+	if(BL_IMAGE_VALID == BL_Boot_Cache_Lookup(CacheKey))
+	{
+		return BL_IMAGE_VALID;
+	}
+	else {/*nothing*/}
+	if(pHeader->ImageCRC == HAL_CRC_Calculate(BL_CRC_ENGINE_OBJ , (uint32_t*)VectorTable , pHeader->ImageSize / 4UL))
+	{
+		ImageStat = BL_IMAGE_VALID;
+	}
+	else {/*nothing*/}
+	if(0U != CacheResult)
+	{
+		BL_Boot_Cache_Record(CacheKey , ImageStat);
+	}
+	else {/*nothing*/}
+	return ImageStat;
+}
+
+/* Slot still holds the image recorded by @ref BL_Boot_Reject_Slot */
+static uint8_t BL_Boot_Slot_Is_Rejected(uint8_t Slot)
+{
+	uint8_t Rejected = 0U;
+#ifdef BL_ENABLE_DUAL_SLOT
+	const BL_Image_Header_t* pHeader = BL_Boot_Get_Image_Header(BL_Boot_Slot_Base(Slot));
+	if(NULL != pHeader)
+	{
+		BL_Boot_Enable_Backup_Access();
+		Rejected = (pHeader->ImageCRC == BL_BOOT_BKP_REG(BL_BOOT_BKP_REJECTED_SLOT_A + Slot)) ? 1U : 0U;
+	}
+	else {/*nothing*/}
+#else
+	UNUSED(Slot);
+#endif
+	return Rejected;
+}
+
+#ifdef BL_ENABLE_DUAL_SLOT
+static void BL_Boot_Reject_Slot(uint8_t Slot)
+{
+	const BL_Image_Header_t* pHeader = BL_Boot_Get_Image_Header(BL_Boot_Slot_Base(Slot));
+	if(NULL != pHeader)
+	{
+		BL_Boot_Enable_Backup_Access();
+		BL_BOOT_BKP_REG(BL_BOOT_BKP_REJECTED_SLOT_A + Slot) = pHeader->ImageCRC;
+	}
+	else {/*nothing*/}
+}
+
+/* Slot to try first : the one with the higher firmware version , slot A on a tie */
+static uint8_t BL_Boot_Newest_Slot(void)
+{
+	const BL_Image_Header_t* pHeaderA = BL_Boot_Get_Image_Header(BL_SLOT_A_BASE_ADDRESS);
+	const BL_Image_Header_t* pHeaderB = BL_Boot_Get_Image_Header(BL_SLOT_B_BASE_ADDRESS);
+	uint8_t Slot = BL_BOOT_SLOT_A;
+
+	if(NULL != pHeaderB)
+	{
+		if((NULL == pHeaderA) || (pHeaderB->FwVersion > pHeaderA->FwVersion))
+		{
+			Slot = BL_BOOT_SLOT_B;
+		}
+		else {/*nothing*/}
+	}
+	else {/*nothing*/}
+	return Slot;
+}
+#endif
+
+static uint8_t BL_Boot_Is_Cold_Reset(void)
+{
+	static uint8_t ResetFlagsRead = 0U;
+	static uint8_t ColdReset = 0U;
+	if(0U == ResetFlagsRead)
+	{
+		/* Reset flags are sticky , keep a copy for the application then clear them
+		 * so the next warm reset is not seen as a cold one */
+		ColdReset = (0UL != (RCC->CSR & BL_BOOT_COLD_RESET_FLAGS)) ? 1U : 0U;
+		BL_BOOT_BKP_REG(BL_BOOT_BKP_RESET_FLAGS) = RCC->CSR;
+		RCC->CSR |= RCC_CSR_RMVF;
+		ResetFlagsRead = 1U;
+	}
+	else {/*nothing*/}
+	return ColdReset;
+}
+static uint8_t BL_Boot_Strap_Is_Active(void)
+{
+	uint8_t StrapActive = 0U;
+#ifdef BL_ENABLE_BOOT_STRAP
+	uint32_t PullConfig = 0UL;
+	volatile uint8_t SettleCounter = 0U;
+	RCC->AHB1ENR |= BL_BOOT_STRAP_GPIO_CLK_EN;
+	(void)RCC->AHB1ENR;
+	/* Input with pull up */
+	PullConfig = BL_BOOT_STRAP_GPIO_PORT->PUPDR;
+	BL_BOOT_STRAP_GPIO_PORT->PUPDR = (PullConfig & ~(0x03UL << (BL_BOOT_STRAP_PIN_NUMBER * 2U))) | (0x01UL << (BL_BOOT_STRAP_PIN_NUMBER * 2U));
+	/* Let the pull up charge the pin */
+	for( ; SettleCounter < 32U ; ++SettleCounter);
+	StrapActive = (((BL_BOOT_STRAP_GPIO_PORT->IDR >> BL_BOOT_STRAP_PIN_NUMBER) & 0x01UL) == BL_BOOT_STRAP_ACTIVE_LEVEL) ? 1U : 0U;
+	/* Back to reset configuration */
+	BL_BOOT_STRAP_GPIO_PORT->PUPDR = PullConfig;
+	RCC->AHB1ENR &= ~BL_BOOT_STRAP_GPIO_CLK_EN;
+#endif
+	return StrapActive;
+}
+
+static uint8_t BL_Boot_Vector_Table_Is_Valid(uint32_t ImageBase)
+{
+	uint32_t MSP_Val = *((volatile uint32_t*)ImageBase);
+	uint32_t ResetHandlerAddress = *((volatile uint32_t*)(ImageBase + 4UL));
+	/* Erased flash reads 0xFFFFFFFF , stack must be in SRAM and reset handler in application flash (thumb) */
+	return ( (MSP_Val > SRAM1_BASE) && (MSP_Val <= BL_STM32F401_SRAM_END) &&
+			 (ResetHandlerAddress > ImageBase) && (ResetHandlerAddress < BL_STM32401_FLASH_END) &&
+			 (0UL != (ResetHandlerAddress & 0x01UL)) ) ? 1U : 0U;
+}
+
+/*****************************************/
@@ -0,0 +1,124 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Boot.h
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Boot.h
+ ******************************************************************************
+ */
+#ifndef APPLICATION_BOOTLOADER_BOOTLOADER_BOOT_H_
+#define APPLICATION_BOOTLOADER_BOOTLOADER_BOOT_H_
+
+/*----------------------- Include Start ---------------------- */
+#include <stdint.h>
+/* ----------------------- Include END ----------------------- */
+
+/* ----------------------- MACROS Start ---------------------- */
+#define BL_IMAGE_INVALID				(0x00U)
+#define BL_IMAGE_VALID					(0x01U)
+
+/*
+ * RTC backup registers used by the bootloader (offset from @ref BL_BOOT_BKP_FIRST_REGISTER)
+ * The application can read the reset flags the bootloader cleared from BL_BOOT_BKP_RESET_FLAGS.
+ * */
+#define BL_BOOT_BKP_CACHE_MAGIC			(0U)
+#define BL_BOOT_BKP_CACHE_KEY			(1U)
+#define BL_BOOT_BKP_CACHE_CHECK			(2U)
+#define BL_BOOT_BKP_RESET_FLAGS			(3U)
+/*
+ * Dual slot boot attempts : (slot << 8) | attempts.
+ * The application confirms a good boot by writing 0 to it , otherwise the bootloader
+ * falls back to the other slot after BL_BOOT_MAX_ATTEMPTS resets.
+ * */
+#define BL_BOOT_BKP_BOOT_ATTEMPTS		(4U)
+/*
+ * ImageCRC of the image that used up its attempts in slot A / B.
+ * The slot is skipped while it holds that image , a new image written to it is tried again.
+ * */
+#define BL_BOOT_BKP_REJECTED_SLOT_A		(5U)
+#define BL_BOOT_BKP_REJECTED_SLOT_B		(6U)
+
+/* Image slots (BL_ENABLE_DUAL_SLOT) */
+#define BL_BOOT_SLOT_A					(0U)
+#define BL_BOOT_SLOT_B					(1U)
+#define BL_BOOT_NUMBER_OF_SLOTS			(2U)
+#define BL_BOOT_NO_SLOT					(0xFFU)
+/* Attempts reported for a slot whose image was rejected */
+#define BL_BOOT_SLOT_REJECTED			(0xFFU)
+
+/*
+ * Images start with @ref BL_Image_Header_t (stamped by Host.py) , the vector table follows at
+ * BL_IMAGE_HEADER_SIZE so it keeps the VTOR alignment (101 vectors -> 512 bytes).
+ * The header is required in a slot and optional at BL_APPLICATION_BASE_ADDRESS ,
+ * an image without it is checked against the sector manifest instead.
+ * */
+#define BL_IMAGE_HEADER_MAGIC			(0x474D4942UL)		/* 'B' 'I' 'M' 'G' */
+#define BL_IMAGE_HEADER_VERSION			(1UL)
+#define BL_IMAGE_HEADER_SIZE			(0x200UL)
+
+/*
+ * Shared RAM block at the start of SRAM (linker section .bl_shared , never initialized)
+ * The application writes BL_BOOT_REQUEST_MAGIC to BootRequest then resets to stay in the bootloader.
+ * The application linker script must keep these sizeof(BL_Boot_Shared_t) bytes (64 reserved) out of
+ * its RAM region , e.g. RAM ORIGIN = 0x20000040 , otherwise its .data / .bss init overwrites
+ * BootRequest before it is read and HandoffCycles / BootTimestamps before the application reads them.
+ * */
+#define BL_BOOT_SHARED_ADDRESS			(0x20000000UL)
+#define BL_BOOT_REQUEST_MAGIC			(0x5354424CUL)		/* 'B' 'L' 'T' 'S' */
+
+/* Boot timestamps (DWT->CYCCNT , cleared at reset) in BL_Boot_Shared.BootTimestamps */
+#define BL_BOOT_TS_RESET				(0U)		/* Start of the early boot decision */
+#define BL_BOOT_TS_CLOCK_READY			(1U)		/* After SystemClock_Config */
+#define BL_BOOT_TS_PERIPHERALS_READY	(2U)		/* After peripherals init */
+#define BL_BOOT_TS_JUMP					(3U)		/* Hand-off to the application starts */
+#define BL_BOOT_NUMBER_OF_TIMESTAMPS	(4U)
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+
+/* ----------------------- Macro Function End ----------------- */
+
+/* ----------------------- User Data Types Start -------------- */
+typedef struct {
+	uint32_t BootRequest;			/* BL_BOOT_REQUEST_MAGIC : stay in bootloader on next reset */
+	uint32_t DecisionCycles;		/* CPU cycles of the early boot decision (HSI clock) */
+	uint32_t HandoffCycles;			/* CPU cycles from hand-off start to the application reset handler */
+	uint32_t BootTimestamps[BL_BOOT_NUMBER_OF_TIMESTAMPS];	/* BL_BOOT_TS_xx , points not reached hold stale values */
+}BL_Boot_Shared_t;
+
+/* Header version 1 , every field little endian */
+typedef struct {
+	uint32_t Magic;					/* BL_IMAGE_HEADER_MAGIC */
+	uint32_t HeaderVersion;			/* BL_IMAGE_HEADER_VERSION */
+	uint32_t FwVersion;				/* Higher version wins when both slots are valid */
+	uint32_t ImageSize;				/* Bytes following the header , multiple of 4 */
+	uint32_t LoadAddress;			/* Vector table address the image is linked for : header address + BL_IMAGE_HEADER_SIZE */
+	uint32_t EntryPoint;			/* Reset handler , must match the vector table */
+	uint32_t ImageCRC;				/* CRC engine result over the image words only */
+	uint32_t HeaderCRC;				/* CRC engine result over the fields above */
+}BL_Image_Header_t;
+
+
+extern BL_Boot_Shared_t BL_Boot_Shared;
+/* ----------------------- User Data Types End ---------------- */
+
+/* ----------------------- Software Interfaces Start ---------- */
+void    BL_Boot_Early_Decision(void);
+uint8_t BL_Boot_Validate_Application(void);
+void    BL_Boot_Invalidate_Validation_Cache(void);
+uint32_t BL_Boot_Select_Image(void);
+uint32_t BL_Boot_Select_Image_At(uint32_t RegionBase);
+uint8_t BL_Boot_Is_Image_Base(uint32_t Address);
+void    BL_Boot_Record_Boot_Attempt(void);
+uint8_t BL_Boot_Get_Active_Slot(void);
+uint32_t BL_Boot_Get_Selected_Image(void);
+uint32_t BL_Boot_Slot_Base(uint8_t Slot);
+uint32_t BL_Boot_Slot_Size(uint8_t Slot);
+uint8_t BL_Boot_Validate_Slot(uint8_t Slot);
+const BL_Image_Header_t* BL_Boot_Get_Image_Header(uint32_t RegionBase);
+uint8_t BL_Boot_Get_Slot_Attempts(uint8_t Slot);
+void    BL_Boot_Clear_Boot_Attempts(void);
+uint8_t BL_Boot_Is_Region_Writable(uint32_t Address , uint32_t DataLen);
+void    BL_Boot_Jump_To_Image(uint32_t ImageBase);
+/* ----------------------- Software Interfaces end ------------ */
+
+#endif /* APPLICATION_BOOTLOADER_BOOTLOADER_BOOT_H_ */
@@ -42,6 +42,33 @@
  * */
 #define BL_HOST_COMMUNICATION_UART		(&(huart2))
 
+/* Baud rates a session can switch to , the first one is the rate set by MX_USART2_UART_Init */
+#define BL_HOST_BAUD_RATES				{115200UL , 230400UL , 460800UL , 921600UL}
+/* An opened session falls back to the defaults and the first baud rate after this long without a frame */
+#define BL_SESSION_IDLE_TIMEOUT_MS		(5000UL)
+
+/* Comment it to refuse word fed frame CRC in sessions (frames keep one CRC word per byte) */
+#define BL_ENABLE_WORD_CRC
+
+/* Comment it to refuse PackBits compressed memory write payloads in sessions */
+#define BL_ENABLE_COMPRESSION
+
+/* Comment it to send bulk replies (memory read) with a blocking UART transmit
+ * DMA stream / channel must be the TX request of BL_HOST_COMMUNICATION_UART (USART2_TX -> DMA1 stream 6 channel 4)
+ * */
+#define BL_ENABLE_HOST_TX_DMA
+#define BL_HOST_TX_DMA_STREAM			(DMA1_Stream6)
+#define BL_HOST_TX_DMA_CHANNEL			(DMA_CHANNEL_4)
+#define BL_HOST_TX_DMA_CLK_ENABLE()		__HAL_RCC_DMA1_CLK_ENABLE()
+
+/* Comment it to stream memory dumps one block per host acknowledgement
+ * Circular RX DMA keeps host acknowledgements while a dump is streaming (USART2_RX -> DMA1 stream 5 channel 4)
+ * */
+#define BL_ENABLE_HOST_RX_DMA
+#define BL_HOST_RX_DMA_STREAM			(DMA1_Stream5)
+#define BL_HOST_RX_DMA_CHANNEL			(DMA_CHANNEL_4)
+#define BL_HOST_RX_DMA_CLK_ENABLE()		__HAL_RCC_DMA1_CLK_ENABLE()
+
 /**/
 #define BL_CRC_ENGINE_OBJ				(&(hcrc))
 
@@ -52,6 +79,46 @@
  * */
 //#define BL_ENABLE_ROP_LEVEL_2
 
+/* Vector table address of the application image started by the bootloader */
+#define BL_APPLICATION_BASE_ADDRESS		(0x08010000UL)
+
+/* Comment it to run the full application check on every reset
+ * When enabled a successful check of manifest generation X is recorded in RTC backup registers
+ * and warm resets skip the CRC scan of the application sectors until the image changes
+ * */
+#define BL_ENABLE_VALIDATION_CACHE
+
+/* First RTC backup register used by the bootloader (7 registers are used) */
+#define BL_BOOT_BKP_FIRST_REGISTER		(0U)
+
+/* Comment it to disable the boot strap pin check of the early boot decision
+ * Strap pin is sampled with the internal pull up , holding it at BL_BOOT_STRAP_ACTIVE_LEVEL
+ * during reset keeps the bootloader running
+ * */
+#define BL_ENABLE_BOOT_STRAP
+#define BL_BOOT_STRAP_GPIO_PORT			(GPIOA)
+#define BL_BOOT_STRAP_GPIO_CLK_EN		(RCC_AHB1ENR_GPIOAEN)
+#define BL_BOOT_STRAP_PIN_NUMBER		(0U)
+#define BL_BOOT_STRAP_ACTIVE_LEVEL		(0U)
+
+/* Uncomment it to boot one of two image slots instead of the single image at BL_APPLICATION_BASE_ADDRESS
+ * Each slot starts with a BL_Image_Header_t , the application is linked at slot base + BL_IMAGE_HEADER_SIZE.
+ * The newest valid slot is started , the other one is the rollback image and the only one the host may write.
+ * */
+//#define BL_ENABLE_DUAL_SLOT
+#define BL_SLOT_A_BASE_ADDRESS			(0x08010000UL)		/* Sector 4 , 64K */
+#define BL_SLOT_A_SIZE					(64UL * 1024UL)
+#define BL_SLOT_B_BASE_ADDRESS			(0x08020000UL)		/* Sector 5 , 128K */
+#define BL_SLOT_B_SIZE					(128UL * 1024UL)
+/* Unconfirmed starts of a slot before falling back to the other one */
+#define BL_BOOT_MAX_ATTEMPTS			(3U)
+
+/* SRAM left to host loaded RAM stubs , must match the STUB region of the linker script
+ * CBL_MEM_WRITE_CMD only writes SRAM inside this region , bootloader data and stack stay untouched
+ * */
+#define BL_STUB_RAM_BASE				(0x20008000UL)
+#define BL_STUB_RAM_SIZE				(32UL * 1024UL)
+#define BL_STUB_RAM_END					(BL_STUB_RAM_BASE + BL_STUB_RAM_SIZE)
 
 
 /* ----------------------- MACROS END ------------------------ */
@@ -0,0 +1,318 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Manifest.c
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Manifest.c
+ *
+ * Per sector CRC manifest of the application flash.
+ * The manifest is an append only log of records in sector 3 , the last valid
+ * record of a sector holds its CRC. Every commit appends one record per dirty
+ * sector , so the log sector is only erased (and compacted) when it is full.
+ ******************************************************************************
+ */
+#include "crc.h"
+#include "Bootloader_CFG.h"
+#include "Bootloader_Manifest.h"
+
+/* ----------------------- MACROS Start ---------------------- */
+#define BL_MANIFEST_BASE_ADDRESS			(0x0800C000UL)
+#define BL_MANIFEST_SIZE					(16UL * 1024UL)
+#define BL_MANIFEST_RECORD_MAGIC			(0x4D460000UL)		/* 'M' 'F' */
+#define BL_MANIFEST_RECORD_MAGIC_MASK		(0xFFFF0000UL)
+#define BL_MANIFEST_ERASED_WORD				(0xFFFFFFFFUL)
+#define BL_MANIFEST_MAX_RECORDS				(BL_MANIFEST_SIZE / sizeof(BL_Manifest_Record_t))
+#define BL_MANIFEST_APP_SECTORS_MASK		((uint8_t)((1U << BL_MANIFEST_NUMBER_OF_APP_SECTORS) - 1U))
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+#define BL_MANIFEST_RECORD_CHECK(_REC)		(~((_REC)->Header ^ (_REC)->Generation ^ (_REC)->SectorCRC))
+#define BL_MANIFEST_APP_IDX(_SECTOR)		((uint8_t)((_SECTOR) - BL_MANIFEST_FIRST_APP_SECTOR))
+#define IS_BL_MANIFEST_APP_SECTOR(_SECTOR)	((BL_MANIFEST_FIRST_APP_SECTOR <= (_SECTOR)) && (BL_FLASH_NUMBER_OF_SECTORS > (_SECTOR)))
+/* ----------------------- Macro Function End ----------------- */
+
+/* ----------------------- User Data Types Start -------------- */
+typedef struct {
+	uint32_t Header;			/* BL_MANIFEST_RECORD_MAGIC | sector number */
+	uint32_t Generation;		/* manifest generation of the commit that wrote the record */
+	uint32_t SectorCRC;			/* CRC engine result over the whole sector */
+	uint32_t Check;				/* BL_MANIFEST_RECORD_CHECK , catches records torn by a reset */
+}BL_Manifest_Record_t;
+
+typedef struct {
+	uint32_t SectorCRC[BL_MANIFEST_NUMBER_OF_APP_SECTORS];
+	uint32_t Generation;
+	uint32_t NextRecord;		/* index of the first erased record in the log */
+	uint8_t  KnownMask;			/* bit n set : sector (n + first app sector) has a CRC */
+	uint8_t  DirtyMask;			/* bit n set : sector written since last commit */
+	uint8_t  Loaded;
+}BL_Manifest_t;
+/* ----------------------- User Data Types End ---------------- */
+
+static void BL_Manifest_Load(void);
+static uint8_t BL_Manifest_Append(uint8_t Sector , uint32_t Generation , uint32_t SectorCRC);
+static uint8_t BL_Manifest_Compact(uint32_t Generation);
+
+static const uint32_t BL_Flash_Sector_Sizes[BL_FLASH_NUMBER_OF_SECTORS] = {
+		16UL * 1024UL , 16UL * 1024UL , 16UL * 1024UL , 16UL * 1024UL , 64UL * 1024UL , 128UL * 1024UL
+};
+
+static BL_Manifest_t BL_Manifest = {.Loaded = 0U};
+
+/* ----------------------- Software Interfaces Start ---------- */
+uint8_t BL_Flash_Address_To_Sector(uint32_t Address)
+{
+	uint8_t Sector = 0U;
+	uint32_t SectorBase = FLASH_BASE;
+	for( ; Sector < BL_FLASH_NUMBER_OF_SECTORS ; ++Sector)
+	{
+		if((Address >= SectorBase) && (Address < (SectorBase + BL_Flash_Sector_Sizes[Sector])))
+		{
+			return Sector;
+		}
+		else {/*nothing*/}
+		SectorBase += BL_Flash_Sector_Sizes[Sector];
+	}
+	return BL_MANIFEST_INVALID_SECTOR;
+}
+
+uint32_t BL_Flash_Sector_Base(uint8_t Sector)
+{
+	uint32_t SectorBase = FLASH_BASE;
+	uint8_t Counter = 0U;
+	for( ; (Counter < Sector) && (Counter < BL_FLASH_NUMBER_OF_SECTORS) ; ++Counter)
+	{
+		SectorBase += BL_Flash_Sector_Sizes[Counter];
+	}
+	return SectorBase;
+}
+
+uint32_t BL_Flash_Sector_Size(uint8_t Sector)
+{
+	return (Sector < BL_FLASH_NUMBER_OF_SECTORS) ? BL_Flash_Sector_Sizes[Sector] : 0UL;
+}
+
+uint32_t BL_Flash_Sector_CRC(uint8_t Sector)
+{
+	/* Word wide feed of the CRC engine , one AHB access per 4 bytes */
+	return HAL_CRC_Calculate(BL_CRC_ENGINE_OBJ , (uint32_t*)BL_Flash_Sector_Base(Sector) , BL_Flash_Sector_Size(Sector) / 4UL);
+}
+
+void BL_Manifest_Mark_Dirty(uint32_t Address , uint32_t DataLen)
+{
+	uint8_t FirstSector = BL_Flash_Address_To_Sector(Address);
+	uint8_t LastSector = BL_Flash_Address_To_Sector(Address + DataLen - 1UL);
+	if((0UL != DataLen) && (BL_MANIFEST_INVALID_SECTOR != FirstSector) && (BL_MANIFEST_INVALID_SECTOR != LastSector))
+	{
+		for( ; FirstSector <= LastSector ; ++FirstSector)
+		{
+			if(IS_BL_MANIFEST_APP_SECTOR(FirstSector))
+			{
+				BL_Manifest.DirtyMask |= (uint8_t)(1U << BL_MANIFEST_APP_IDX(FirstSector));
+			}
+			else {/*nothing*/}
+		}
+	}
+	else {/*nothing*/}
+}
+
+void BL_Manifest_Mark_Sectors_Erased(uint8_t FirstSector , uint8_t NumberOfSectors)
+{
+	uint8_t Sector = FirstSector;
+	for( ; (Sector < (FirstSector + NumberOfSectors)) && (Sector < BL_FLASH_NUMBER_OF_SECTORS) ; ++Sector)
+	{
+		if(BL_MANIFEST_FLASH_SECTOR == Sector)
+		{
+			/* Log itself is gone , reload (empty) on next access */
+			BL_Manifest.Loaded = 0U;
+		}
+		else
+		{
+			BL_Manifest_Mark_Dirty(BL_Flash_Sector_Base(Sector) , 1UL);
+		}
+	}
+}
+
+uint8_t BL_Manifest_Commit(void)
+{
+	uint8_t CommitStat = BL_MANIFEST_COMMIT_PASSED;
+	uint8_t DirtyMask = 0U;
+	uint8_t Idx = 0U;
+	uint32_t SectorCRC = 0UL;
+	BL_Manifest_Load();
+	/* Sectors never recorded are scanned once as well */
+	DirtyMask = BL_Manifest.DirtyMask | (uint8_t)(~BL_Manifest.KnownMask & BL_MANIFEST_APP_SECTORS_MASK);
+	if(0U != DirtyMask)
+	{
+		/* Only the sectors touched since last commit are re-scanned */
+		for( ; Idx < BL_MANIFEST_NUMBER_OF_APP_SECTORS ; ++Idx)
+		{
+			if(DirtyMask & (1U << Idx))
+			{
+				BL_Manifest.SectorCRC[Idx] = BL_Flash_Sector_CRC(Idx + BL_MANIFEST_FIRST_APP_SECTOR);
+				BL_Manifest.KnownMask |= (uint8_t)(1U << Idx);
+			}
+			else {/*nothing*/}
+		}
+		++BL_Manifest.Generation;
+		if((BL_Manifest.NextRecord + BL_MANIFEST_NUMBER_OF_APP_SECTORS) > BL_MANIFEST_MAX_RECORDS)
+		{
+			/* Log full : erase it and keep only the last record of every sector */
+			CommitStat = BL_Manifest_Compact(BL_Manifest.Generation);
+		}
+		else
+		{
+			for(Idx = 0U ; (Idx < BL_MANIFEST_NUMBER_OF_APP_SECTORS) && (BL_MANIFEST_COMMIT_PASSED == CommitStat) ; ++Idx)
+			{
+				if(DirtyMask & (1U << Idx))
+				{
+					SectorCRC = BL_Manifest.SectorCRC[Idx];
+					CommitStat = BL_Manifest_Append(Idx + BL_MANIFEST_FIRST_APP_SECTOR , BL_Manifest.Generation , SectorCRC);
+				}
+				else {/*nothing*/}
+			}
+		}
+		if(BL_MANIFEST_COMMIT_PASSED == CommitStat)
+		{
+			BL_Manifest.DirtyMask = 0U;
+		}
+		else
+		{
+			/* Flash content unknown , rebuild RAM copy from the log */
+			BL_Manifest.Loaded = 0U;
+		}
+	}
+	else {/*nothing*/}
+	return CommitStat;
+}
+
+uint8_t BL_Manifest_Validate_Sector(uint8_t Sector)
+{
+	uint8_t SectorStat = BL_MANIFEST_SECTOR_UNKNOWN;
+	uint32_t StoredCRC = 0UL;
+	if(BL_MANIFEST_SECTOR_MATCH == BL_Manifest_Get_Sector_CRC(Sector , &StoredCRC))
+	{
+		SectorStat = (StoredCRC == BL_Flash_Sector_CRC(Sector)) ? BL_MANIFEST_SECTOR_MATCH : BL_MANIFEST_SECTOR_MISMATCH;
+	}
+	else {/*nothing*/}
+	return SectorStat;
+}
+
+/*
+ * Returns BL_MANIFEST_SECTOR_MATCH if the manifest holds an up to date CRC for the sector ,
+ * BL_MANIFEST_SECTOR_UNKNOWN otherwise (never committed or written since last commit).
+ * */
+uint8_t BL_Manifest_Get_Sector_CRC(uint8_t Sector , uint32_t* pSectorCRC)
+{
+	uint8_t Idx = BL_MANIFEST_APP_IDX(Sector);
+	BL_Manifest_Load();
+	if(IS_BL_MANIFEST_APP_SECTOR(Sector) && (BL_Manifest.KnownMask & (1U << Idx)) && !(BL_Manifest.DirtyMask & (1U << Idx)))
+	{
+		*pSectorCRC = BL_Manifest.SectorCRC[Idx];
+		return BL_MANIFEST_SECTOR_MATCH;
+	}
+	else {/*nothing*/}
+	return BL_MANIFEST_SECTOR_UNKNOWN;
+}
+
+uint32_t BL_Manifest_Get_Generation(void)
+{
+	BL_Manifest_Load();
+	return BL_Manifest.Generation;
+}
+
+uint8_t BL_Manifest_Get_Dirty_Mask(void)
+{
+	return BL_Manifest.DirtyMask;
+}
+/* ----------------------- Software Interfaces end ------------ */
+
+/*Static private functions Declarations*/
+static void BL_Manifest_Load(void)
+{
+	const BL_Manifest_Record_t* pRecord = (const BL_Manifest_Record_t*)BL_MANIFEST_BASE_ADDRESS;
+	uint8_t Sector = 0U;
+	if(0U == BL_Manifest.Loaded)
+	{
+		BL_Manifest.KnownMask = 0U;
+		BL_Manifest.Generation = 0UL;
+		BL_Manifest.NextRecord = 0UL;
+		/* Replay the log , later records override earlier ones */
+		for( ; (BL_Manifest.NextRecord < BL_MANIFEST_MAX_RECORDS) && (BL_MANIFEST_ERASED_WORD != pRecord->Header) ; ++pRecord)
+		{
+			++BL_Manifest.NextRecord;
+			Sector = (uint8_t)(pRecord->Header & 0xFFUL);
+			if( ((pRecord->Header & BL_MANIFEST_RECORD_MAGIC_MASK) == BL_MANIFEST_RECORD_MAGIC) &&
+				(pRecord->Check == BL_MANIFEST_RECORD_CHECK(pRecord)) &&
+				IS_BL_MANIFEST_APP_SECTOR(Sector) )
+			{
+				BL_Manifest.SectorCRC[BL_MANIFEST_APP_IDX(Sector)] = pRecord->SectorCRC;
+				BL_Manifest.KnownMask |= (uint8_t)(1U << BL_MANIFEST_APP_IDX(Sector));
+				if(pRecord->Generation > BL_Manifest.Generation)
+				{
+					BL_Manifest.Generation = pRecord->Generation;
+				}
+				else {/*nothing*/}
+			}
+			else {/*nothing*/}
+		}
+		BL_Manifest.Loaded = 1U;
+	}
+	else {/*nothing*/}
+}
+
+static uint8_t BL_Manifest_Append(uint8_t Sector , uint32_t Generation , uint32_t SectorCRC)
+{
+	HAL_StatusTypeDef HAL_stat = HAL_OK;
+	BL_Manifest_Record_t Record = {
+			.Header = BL_MANIFEST_RECORD_MAGIC | (uint32_t)Sector,
+			.Generation = Generation,
+			.SectorCRC = SectorCRC
+	};
+	uint32_t RecordAddress = BL_MANIFEST_BASE_ADDRESS + (BL_Manifest.NextRecord * sizeof(BL_Manifest_Record_t));
+	Record.Check = BL_MANIFEST_RECORD_CHECK(&Record);
+
+	HAL_stat |= HAL_FLASH_Unlock();
+	/* Header is programmed first so a torn record is still skipped by the replay */
+	HAL_stat |= HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD , RecordAddress , Record.Header);
+	HAL_stat |= HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD , RecordAddress + 4UL , Record.Generation);
+	HAL_stat |= HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD , RecordAddress + 8UL , Record.SectorCRC);
+	HAL_stat |= HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD , RecordAddress + 12UL , Record.Check);
+	HAL_stat |= HAL_FLASH_Lock();
+	++BL_Manifest.NextRecord;
+
+	return (HAL_OK == HAL_stat) ? BL_MANIFEST_COMMIT_PASSED : BL_MANIFEST_COMMIT_FAILED;
+}
+
+static uint8_t BL_Manifest_Compact(uint32_t Generation)
+{
+	uint8_t CommitStat = BL_MANIFEST_COMMIT_FAILED;
+	uint8_t Idx = 0U;
+	uint32_t SectorError = 0UL;
+	HAL_StatusTypeDef HAL_stat = HAL_OK;
+	FLASH_EraseInitTypeDef EraseInit = {
+			.TypeErase = FLASH_TYPEERASE_SECTORS,
+			.Banks = FLASH_BANK_1,
+			.Sector = BL_MANIFEST_FLASH_SECTOR,
+			.NbSectors = 1UL,
+			.VoltageRange = FLASH_VOLTAGE_RANGE_3
+	};
+	HAL_stat |= HAL_FLASH_Unlock();
+	HAL_stat |= HAL_FLASHEx_Erase(&EraseInit , &SectorError);
+	HAL_stat |= HAL_FLASH_Lock();
+	if(HAL_OK == HAL_stat)
+	{
+		CommitStat = BL_MANIFEST_COMMIT_PASSED;
+		BL_Manifest.NextRecord = 0UL;
+		for( ; (Idx < BL_MANIFEST_NUMBER_OF_APP_SECTORS) && (BL_MANIFEST_COMMIT_PASSED == CommitStat) ; ++Idx)
+		{
+			if(BL_Manifest.KnownMask & (1U << Idx))
+			{
+				CommitStat = BL_Manifest_Append(Idx + BL_MANIFEST_FIRST_APP_SECTOR , Generation , BL_Manifest.SectorCRC[Idx]);
+			}
+			else {/*nothing*/}
+		}
+	}
+	else {/*nothing*/}
+	return CommitStat;
+}
+/*****************************************/
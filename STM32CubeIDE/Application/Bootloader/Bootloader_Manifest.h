@@ -0,0 +1,61 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Manifest.h
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Manifest.h
+ ******************************************************************************
+ */
+#ifndef APPLICATION_BOOTLOADER_BOOTLOADER_MANIFEST_H_
+#define APPLICATION_BOOTLOADER_BOOTLOADER_MANIFEST_H_
+
+/*----------------------- Include Start ---------------------- */
+#include <stdint.h>
+/* ----------------------- Include END ----------------------- */
+
+/* ----------------------- MACROS Start ---------------------- */
+/*
+ * STM32F401CC flash layout : 16K | 16K | 16K | 16K | 64K | 128K
+ * sector 0..2  -> bootloader code
+ * sector 3     -> bootloader manifest (not used by the linker)
+ * sector 4..5  -> application
+ * */
+#define BL_FLASH_NUMBER_OF_SECTORS			(6U)
+#define BL_MANIFEST_FLASH_SECTOR			(3U)
+#define BL_MANIFEST_FIRST_APP_SECTOR		(4U)
+#define BL_MANIFEST_NUMBER_OF_APP_SECTORS	(BL_FLASH_NUMBER_OF_SECTORS - BL_MANIFEST_FIRST_APP_SECTOR)
+
+#define BL_MANIFEST_INVALID_SECTOR			(0xFFU)
+
+/* Sector state reported by @ref BL_Manifest_Validate_Sector */
+#define BL_MANIFEST_SECTOR_UNKNOWN			(0x00U)
+#define BL_MANIFEST_SECTOR_MATCH			(0x01U)
+#define BL_MANIFEST_SECTOR_MISMATCH			(0x02U)
+
+#define BL_MANIFEST_COMMIT_FAILED			(0x00U)
+#define BL_MANIFEST_COMMIT_PASSED			(0x01U)
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+
+/* ----------------------- Macro Function End ----------------- */
+
+/* ----------------------- User Data Types Start -------------- */
+
+/* ----------------------- User Data Types End ---------------- */
+
+/* ----------------------- Software Interfaces Start ---------- */
+uint8_t  BL_Flash_Address_To_Sector(uint32_t Address);
+uint32_t BL_Flash_Sector_Base(uint8_t Sector);
+uint32_t BL_Flash_Sector_Size(uint8_t Sector);
+uint32_t BL_Flash_Sector_CRC(uint8_t Sector);
+
+void     BL_Manifest_Mark_Dirty(uint32_t Address , uint32_t DataLen);
+void     BL_Manifest_Mark_Sectors_Erased(uint8_t FirstSector , uint8_t NumberOfSectors);
+uint8_t  BL_Manifest_Commit(void);
+uint8_t  BL_Manifest_Validate_Sector(uint8_t Sector);
+uint8_t  BL_Manifest_Get_Sector_CRC(uint8_t Sector , uint32_t* pSectorCRC);
+uint32_t BL_Manifest_Get_Generation(void);
+uint8_t  BL_Manifest_Get_Dirty_Mask(void);
+/* ----------------------- Software Interfaces end ------------ */
+
+#endif /* APPLICATION_BOOTLOADER_BOOTLOADER_MANIFEST_H_ */
@@ -0,0 +1,162 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_SHA256.c
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_SHA256.c
+ *
+ * Streaming SHA-256 (FIPS 180-4) sized for the bootloader flash budget:
+ * the rounds are rolled into one loop and the message schedule is kept in a
+ * 16 word circular buffer instead of the usual 64 words.
+ * Rotations and byte swaps map to single ROR / REV instructions on the Cortex-M4.
+ ******************************************************************************
+ */
+#include "main.h"
+#include <string.h>
+#include "Bootloader_SHA256.h"
+
+/* ----------------------- Macro Functions Start -------------- */
+#define SHA256_CH(_X , _Y , _Z)		(((_X) & (_Y)) ^ (~(_X) & (_Z)))
+#define SHA256_MAJ(_X , _Y , _Z)	(((_X) & (_Y)) ^ ((_X) & (_Z)) ^ ((_Y) & (_Z)))
+#define SHA256_EP0(_X)				(__ROR((_X) , 2U) ^ __ROR((_X) , 13U) ^ __ROR((_X) , 22U))
+#define SHA256_EP1(_X)				(__ROR((_X) , 6U) ^ __ROR((_X) , 11U) ^ __ROR((_X) , 25U))
+#define SHA256_SIG0(_X)				(__ROR((_X) , 7U) ^ __ROR((_X) , 18U) ^ ((_X) >> 3U))
+#define SHA256_SIG1(_X)				(__ROR((_X) , 17U) ^ __ROR((_X) , 19U) ^ ((_X) >> 10U))
+/* ----------------------- Macro Function End ----------------- */
+
+static void BL_SHA256_Transform(BL_SHA256_Ctx_t* pCtx , const uint8_t* pBlock);
+
+/* Round constants, kept in flash */
+static const uint32_t BL_SHA256_K[64U] = {
+		0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+		0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+		0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL, 0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+		0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+		0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+		0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+		0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+		0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL, 0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+/* ----------------------- Software Interfaces Start ---------- */
+void BL_SHA256_Init(BL_SHA256_Ctx_t* pCtx)
+{
+	pCtx->State[0U] = 0x6a09e667UL;
+	pCtx->State[1U] = 0xbb67ae85UL;
+	pCtx->State[2U] = 0x3c6ef372UL;
+	pCtx->State[3U] = 0xa54ff53aUL;
+	pCtx->State[4U] = 0x510e527fUL;
+	pCtx->State[5U] = 0x9b05688cUL;
+	pCtx->State[6U] = 0x1f83d9abUL;
+	pCtx->State[7U] = 0x5be0cd19UL;
+	pCtx->TotalLen = 0UL;
+	pCtx->BlockLen = 0U;
+}
+
+void BL_SHA256_Update(BL_SHA256_Ctx_t* pCtx , const uint8_t* pData , uint32_t DataLen)
+{
+	uint32_t CopyLen = 0UL;
+	pCtx->TotalLen += DataLen;
+	/* Complete a previously started block first */
+	if(pCtx->BlockLen != 0U)
+	{
+		CopyLen = BL_SHA256_BLOCK_SIZE - pCtx->BlockLen;
+		if(CopyLen > DataLen)
+		{
+			CopyLen = DataLen;
+		}
+		else {/*nothing*/}
+		memcpy(&pCtx->Block[pCtx->BlockLen] , pData , CopyLen);
+		pCtx->BlockLen += (uint8_t)CopyLen;
+		pData += CopyLen;
+		DataLen -= CopyLen;
+		if(BL_SHA256_BLOCK_SIZE == pCtx->BlockLen)
+		{
+			BL_SHA256_Transform(pCtx , pCtx->Block);
+			pCtx->BlockLen = 0U;
+		}
+		else {/*nothing*/}
+	}
+	else {/*nothing*/}
+	/* Hash full blocks straight from the caller buffer (flash or SRAM), no copy */
+	for( ; DataLen >= BL_SHA256_BLOCK_SIZE ; DataLen -= BL_SHA256_BLOCK_SIZE)
+	{
+		BL_SHA256_Transform(pCtx , pData);
+		pData += BL_SHA256_BLOCK_SIZE;
+	}
+	/* Keep the tail for the next call */
+	if(DataLen != 0U)
+	{
+		memcpy(pCtx->Block , pData , DataLen);
+		pCtx->BlockLen = (uint8_t)DataLen;
+	}
+	else {/*nothing*/}
+}
+
+void BL_SHA256_Final(BL_SHA256_Ctx_t* pCtx , uint8_t* pDigest)
+{
+	uint32_t BitLenHigh = pCtx->TotalLen >> 29U;
+	uint32_t BitLenLow  = pCtx->TotalLen << 3U;
+	uint8_t Counter = 0U;
+	/* Append the '1' bit then pad with zeros up to 56 bytes of the last block */
+	pCtx->Block[pCtx->BlockLen++] = 0x80U;
+	if(pCtx->BlockLen > (BL_SHA256_BLOCK_SIZE - 8U))
+	{
+		memset(&pCtx->Block[pCtx->BlockLen] , 0 , BL_SHA256_BLOCK_SIZE - pCtx->BlockLen);
+		BL_SHA256_Transform(pCtx , pCtx->Block);
+		pCtx->BlockLen = 0U;
+	}
+	else {/*nothing*/}
+	memset(&pCtx->Block[pCtx->BlockLen] , 0 , (BL_SHA256_BLOCK_SIZE - 8U) - pCtx->BlockLen);
+	/* Message length in bits , big endian */
+	*((uint32_t*)(&pCtx->Block[56U])) = __REV(BitLenHigh);
+	*((uint32_t*)(&pCtx->Block[60U])) = __REV(BitLenLow);
+	BL_SHA256_Transform(pCtx , pCtx->Block);
+
+	for( ; Counter < 8U ; ++Counter)
+	{
+		pDigest[(Counter * 4U) + 0U] = (uint8_t)(pCtx->State[Counter] >> 24U);
+		pDigest[(Counter * 4U) + 1U] = (uint8_t)(pCtx->State[Counter] >> 16U);
+		pDigest[(Counter * 4U) + 2U] = (uint8_t)(pCtx->State[Counter] >> 8U);
+		pDigest[(Counter * 4U) + 3U] = (uint8_t)(pCtx->State[Counter]);
+	}
+}
+/* ----------------------- Software Interfaces end ------------ */
+
+/*Static private functions Declarations*/
+static void BL_SHA256_Transform(BL_SHA256_Ctx_t* pCtx , const uint8_t* pBlock)
+{
+	uint32_t W[16U];
+	uint32_t S[8U];
+	uint32_t T1 = 0UL;
+	uint32_t T2 = 0UL;
+	uint8_t Round = 0U;
+
+	memcpy(S , pCtx->State , sizeof(S));
+	for( ; Round < 64U ; ++Round)
+	{
+		if(Round < 16U)
+		{
+			/* Cortex-M4 supports unaligned word loads , input words are big endian */
+			W[Round] = __REV(__UNALIGNED_UINT32_READ(pBlock + (Round * 4U)));
+		}
+		else
+		{
+			W[Round & 0x0FU] += SHA256_SIG1(W[(Round + 14U) & 0x0FU]) + W[(Round + 9U) & 0x0FU] + SHA256_SIG0(W[(Round + 1U) & 0x0FU]);
+		}
+		T1 = S[7U] + SHA256_EP1(S[4U]) + SHA256_CH(S[4U] , S[5U] , S[6U]) + BL_SHA256_K[Round] + W[Round & 0x0FU];
+		T2 = SHA256_EP0(S[0U]) + SHA256_MAJ(S[0U] , S[1U] , S[2U]);
+		S[7U] = S[6U];
+		S[6U] = S[5U];
+		S[5U] = S[4U];
+		S[4U] = S[3U] + T1;
+		S[3U] = S[2U];
+		S[2U] = S[1U];
+		S[1U] = S[0U];
+		S[0U] = T1 + T2;
+	}
+	for(Round = 0U ; Round < 8U ; ++Round)
+	{
+		pCtx->State[Round] += S[Round];
+	}
+}
+/*****************************************/
@@ -0,0 +1,39 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_SHA256.h
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_SHA256.h
+ ******************************************************************************
+ */
+#ifndef APPLICATION_BOOTLOADER_BOOTLOADER_SHA256_H_
+#define APPLICATION_BOOTLOADER_BOOTLOADER_SHA256_H_
+
+/*----------------------- Include Start ---------------------- */
+#include <stdint.h>
+/* ----------------------- Include END ----------------------- */
+
+/* ----------------------- MACROS Start ---------------------- */
+#define BL_SHA256_BLOCK_SIZE		(64U)
+#define BL_SHA256_DIGEST_SIZE		(32U)
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+
+/* ----------------------- Macro Function End ----------------- */
+
+/* ----------------------- User Data Types Start -------------- */
+typedef struct {
+	uint32_t State[8U];							/* Intermediate hash value H0..H7 */
+	uint32_t TotalLen;							/* Number of bytes hashed so far */
+	uint8_t  Block[BL_SHA256_BLOCK_SIZE];		/* Pending input that did not fill a full block yet */
+	uint8_t  BlockLen;
+}BL_SHA256_Ctx_t;
+/* ----------------------- User Data Types End ---------------- */
+
+/* ----------------------- Software Interfaces Start ---------- */
+void BL_SHA256_Init(BL_SHA256_Ctx_t* pCtx);
+void BL_SHA256_Update(BL_SHA256_Ctx_t* pCtx , const uint8_t* pData , uint32_t DataLen);
+void BL_SHA256_Final(BL_SHA256_Ctx_t* pCtx , uint8_t* pDigest);
+/* ----------------------- Software Interfaces end ------------ */
+
+#endif /* APPLICATION_BOOTLOADER_BOOTLOADER_SHA256_H_ */
@@ -0,0 +1,86 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Stub.c
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Stub.c
+ ******************************************************************************
+ */
+#include "Bootloader.h"
+#include "Bootloader_private.h"
+
+static uint32_t BL_Stub_Trampoline(uint32_t Entry , uint32_t StackTop , const BL_Stub_Api_t* pApi , uint32_t Arg);
+
+/* ----------------------- Software Interfaces Start ---------- */
+/*
+ * Stub must sit in the stub region with a complete header : right ABI version ,
+ * entry and stack inside the stub region and a CRC matching the loaded words.
+ * */
+uint8_t BL_Stub_Validate(uint32_t StubBase)
+{
+	const BL_Stub_Header_t* pHeader = (const BL_Stub_Header_t*)StubBase;
+	uint32_t StubEnd = 0UL;
+
+	if( (StubBase < BL_STUB_RAM_BASE) || (StubBase > (BL_STUB_RAM_END - sizeof(BL_Stub_Header_t))) ||
+		(0UL != (StubBase & 0x03UL)) )
+	{
+		return BL_STUB_INVALID;
+	}
+	else {/*nothing*/}
+	StubEnd = StubBase + pHeader->Size;
+	if( (BL_STUB_MAGIC != pHeader->Magic) || (BL_STUB_API_VERSION != pHeader->ApiVersion) ||
+		(pHeader->Size <= sizeof(BL_Stub_Header_t)) || (0UL != (pHeader->Size & 0x03UL)) ||
+		(pHeader->Size > (BL_STUB_RAM_END - StubBase)) ||
+		(0UL == (pHeader->Entry & 0x01UL)) ||
+		((pHeader->Entry & ~0x01UL) < (StubBase + sizeof(BL_Stub_Header_t))) || ((pHeader->Entry & ~0x01UL) >= StubEnd) )
+	{
+		return BL_STUB_INVALID;
+	}
+	else {/*nothing*/}
+	/* Own stack : top of a free area above the stub , kept 8 byte aligned for AAPCS */
+	if( (0UL != pHeader->StackTop) &&
+		((pHeader->StackTop <= StubEnd) || (pHeader->StackTop > BL_STUB_RAM_END) || (0UL != (pHeader->StackTop & 0x07UL))) )
+	{
+		return BL_STUB_INVALID;
+	}
+	else {/*nothing*/}
+	if(pHeader->StubCRC != HAL_CRC_Calculate(BL_CRC_ENGINE_OBJ , (uint32_t*)(StubBase + sizeof(BL_Stub_Header_t)) ,
+			(pHeader->Size - sizeof(BL_Stub_Header_t)) / 4UL))
+	{
+		return BL_STUB_INVALID;
+	}
+	else {/*nothing*/}
+	return BL_STUB_VALID;
+}
+
+/* Runs an already validated stub and returns its return value */
+uint32_t BL_Stub_Call(uint32_t StubBase , const BL_Stub_Api_t* pApi , uint32_t Arg)
+{
+	const BL_Stub_Header_t* pHeader = (const BL_Stub_Header_t*)StubBase;
+	/* Stub code was written through the data bus */
+	__DSB();
+	__ISB();
+	return BL_Stub_Trampoline(pHeader->Entry , pHeader->StackTop , pApi , Arg);
+}
+/* ----------------------- Software Interfaces end ------------ */
+
+/*Static private functions Declarations*/
+/*
+ * r0 = Entry , r1 = StackTop , r2 = pApi , r3 = Arg.
+ * Bootloader SP is kept in r4 (callee saved) while the stub runs on its own stack.
+ * */
+__attribute__((naked)) static uint32_t BL_Stub_Trampoline(uint32_t Entry , uint32_t StackTop , const BL_Stub_Api_t* pApi , uint32_t Arg)
+{
+	__ASM volatile ("PUSH {r4, lr}\n\t"
+					"MOV  r4, sp\n\t"
+					"CBZ  r1, 1f\n\t"
+					"MOV  sp, r1\n"
+					"1:\n\t"
+					"MOV  r12, r0\n\t"
+					"MOV  r0, r2\n\t"
+					"MOV  r1, r3\n\t"
+					"BLX  r12\n\t"
+					"MOV  sp, r4\n\t"
+					"POP  {r4, pc}");
+}
+
+/*****************************************/
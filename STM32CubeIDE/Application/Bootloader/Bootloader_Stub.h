@@ -0,0 +1,64 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Stub.h
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Stub.h
+ *
+ * RAM stub ABI , what a host loaded stub has to follow :
+ *  - Linked to run at BL_STUB_RAM_BASE and written there with CBL_MEM_WRITE_CMD.
+ *  - Starts with @ref BL_Stub_Header_t , code and data follow it.
+ *  - Entry is a thumb function : uint32_t Entry(const BL_Stub_Api_t* pApi , uint32_t Arg).
+ *    It runs privileged , on the bootloader vector table with SysTick running ,
+ *    on its own stack when StackTop is set or on the bootloader stack otherwise.
+ *  - Returning gives control back to the bootloader which reports the return value
+ *    to the host. r4-r11 must be preserved (AAPCS) , host UART settings must be restored.
+ ******************************************************************************
+ */
+#ifndef APPLICATION_BOOTLOADER_BOOTLOADER_STUB_H_
+#define APPLICATION_BOOTLOADER_BOOTLOADER_STUB_H_
+
+/*----------------------- Include Start ---------------------- */
+#include <stdint.h>
+/* ----------------------- Include END ----------------------- */
+
+/* ----------------------- MACROS Start ---------------------- */
+#define BL_STUB_MAGIC					(0x42555453UL)		/* 'S' 'T' 'U' 'B' */
+#define BL_STUB_API_VERSION				(1UL)
+
+#define BL_STUB_INVALID			(0x00U)
+#define BL_STUB_VALID			(0x01U)
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+
+/* ----------------------- Macro Function End ----------------- */
+
+/* ----------------------- User Data Types Start -------------- */
+typedef struct {
+	uint32_t Magic;					/* BL_STUB_MAGIC */
+	uint32_t ApiVersion;			/* BL_STUB_API_VERSION the stub was built for */
+	uint32_t Size;					/* Header + code + data , multiple of 4 */
+	uint32_t Entry;					/* Thumb address of the entry function , inside the stub */
+	uint32_t StackTop;				/* Initial stack , 8 byte aligned inside the stub region , 0 -> bootloader stack */
+	uint32_t StubCRC;				/* CRC engine result over the words following the header */
+}BL_Stub_Header_t;
+
+/* Bootloader services handed to the stub */
+typedef struct {
+	uint32_t ApiVersion;			/* BL_STUB_API_VERSION */
+	uint32_t CoreClockHz;			/* SystemCoreClock when the stub is called */
+	void*    pHostUart;				/* UART_HandleTypeDef of the host link */
+	void*    pCrc;					/* CRC_HandleTypeDef of the CRC engine */
+	uint8_t  (*pfnMemoryWrite)(uint8_t* pData , uint8_t DataLen , uint32_t Address);		/* CBL_MEM_WRITE_CMD backend : application flash or stub region , one region per call */
+	uint8_t  (*pfnFlashErase)(uint8_t SectorNum , uint8_t NumberOfSectors);				/* CBL_FLASH_ERASE_CMD backend */
+}BL_Stub_Api_t;
+
+typedef uint32_t (*BL_Stub_Entry_t)(const BL_Stub_Api_t* pApi , uint32_t Arg);
+/* ----------------------- User Data Types End ---------------- */
+
+/* ----------------------- Software Interfaces Start ---------- */
+uint8_t BL_Stub_Validate(uint32_t StubBase);
+uint32_t BL_Stub_Call(uint32_t StubBase , const BL_Stub_Api_t* pApi , uint32_t Arg);
+/* ----------------------- Software Interfaces end ------------ */
+
+#endif /* APPLICATION_BOOTLOADER_BOOTLOADER_STUB_H_ */
@@ -0,0 +1,62 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Timing.c
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Timing.c
+ *
+ * DWT CYCCNT instrumentation : boot timestamps go to the shared RAM block so the
+ * application can read them too , per command phases are kept for CBL_GET_TIMING_CMD.
+ * Cycles are counted at the running core clock (HSI before SystemClock_Config).
+ ******************************************************************************
+ */
+#include "Bootloader.h"
+#include "Bootloader_private.h"
+
+static BL_Timing_Command_t BL_Timing_Current;
+static BL_Timing_Command_t BL_Timing_Commands[BL_NUMBER_OF_COMMAND];
+static uint32_t BL_Timing_Command_Start = 0UL;
+
+/* ----------------------- Software Interfaces Start ---------- */
+void BL_Timing_Enable(void)
+{
+	/* Enable trace block then DWT cycle counter (no effect if already running) */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void BL_Timing_Boot_Stamp(uint8_t BootPoint)
+{
+	if(BootPoint < BL_BOOT_NUMBER_OF_TIMESTAMPS)
+	{
+		BL_Boot_Shared.BootTimestamps[BootPoint] = BL_TIMING_NOW();
+	}
+	else {/*nothing*/}
+}
+
+/* Call once the whole frame is received , ReceiveStartCycles is taken right after the length byte */
+void BL_Timing_Command_Begin(uint32_t ReceiveStartCycles)
+{
+	memset(&BL_Timing_Current , 0 , sizeof(BL_Timing_Current));
+	BL_Timing_Command_Start = ReceiveStartCycles;
+	BL_Timing_Current.Phase[BL_TIMING_PHASE_RECEIVE] = BL_TIMING_NOW() - ReceiveStartCycles;
+}
+
+void BL_Timing_Phase_Add(uint8_t Phase , uint32_t StartCycles)
+{
+	BL_Timing_Current.Phase[Phase] += BL_TIMING_NOW() - StartCycles;
+}
+
+void BL_Timing_Command_End(uint8_t CommandIdx)
+{
+	BL_Timing_Current.Total = BL_TIMING_NOW() - BL_Timing_Command_Start;
+	BL_Timing_Current.Count = BL_Timing_Commands[CommandIdx].Count + 1UL;
+	BL_Timing_Commands[CommandIdx] = BL_Timing_Current;
+}
+
+const BL_Timing_Command_t* BL_Timing_Get_Command(uint8_t CommandIdx)
+{
+	return &BL_Timing_Commands[CommandIdx];
+}
+/* ----------------------- Software Interfaces end ------------ */
+
+/*****************************************/
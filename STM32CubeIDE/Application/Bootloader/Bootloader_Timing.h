@@ -0,0 +1,45 @@
+/*
+ ******************************************************************************
+ * @file           : Bootloader_Timing.h
+ * @author         : Youssef Ibrahem
+ * @brief          : Bootloader_Timing.h
+ ******************************************************************************
+ */
+#ifndef APPLICATION_BOOTLOADER_BOOTLOADER_TIMING_H_
+#define APPLICATION_BOOTLOADER_BOOTLOADER_TIMING_H_
+
+/*----------------------- Include Start ---------------------- */
+#include <stdint.h>
+/* ----------------------- Include END ----------------------- */
+
+/* ----------------------- MACROS Start ---------------------- */
+/* Phases of one host command , in CPU cycles */
+#define BL_TIMING_PHASE_RECEIVE			(0U)		/* Rest of the frame after the length byte */
+#define BL_TIMING_PHASE_CRC				(1U)		/* Frame CRC verification */
+#define BL_TIMING_PHASE_FLASH			(2U)		/* Flash program / erase / manifest commit */
+#define BL_TIMING_PHASE_REPLY			(3U)		/* ACK , NACK and reply data transmission */
+#define BL_TIMING_NUMBER_OF_PHASES		(4U)
+/* ----------------------- MACROS END ------------------------ */
+
+/* ----------------------- Macro Functions Start -------------- */
+#define BL_TIMING_NOW()					(DWT->CYCCNT)
+/* ----------------------- Macro Function End ----------------- */
+
+/* ----------------------- User Data Types Start -------------- */
+typedef struct {
+	uint32_t Count;								/* Number of dispatches of the command */
+	uint32_t Phase[BL_TIMING_NUMBER_OF_PHASES];	/* Cycles per phase of the last dispatch */
+	uint32_t Total;								/* Cycles from the length byte to the end of the handler */
+}BL_Timing_Command_t;
+/* ----------------------- User Data Types End ---------------- */
+
+/* ----------------------- Software Interfaces Start ---------- */
+void BL_Timing_Enable(void);
+void BL_Timing_Boot_Stamp(uint8_t BootPoint);
+void BL_Timing_Command_Begin(uint32_t ReceiveStartCycles);
+void BL_Timing_Phase_Add(uint8_t Phase , uint32_t StartCycles);
+void BL_Timing_Command_End(uint8_t CommandIdx);
+const BL_Timing_Command_t* BL_Timing_Get_Command(uint8_t CommandIdx);
+/* ----------------------- Software Interfaces end ------------ */
+
+#endif /* APPLICATION_BOOTLOADER_BOOTLOADER_TIMING_H_ */
@@ -14,7 +14,7 @@
 
 
 /* ----------------------- MACROS Start ---------------------- */
-#define BL_NUMBER_OF_COMMAND		(8U)
+#define BL_NUMBER_OF_COMMAND		(19U)
 	/* 			BL Commands  start 		*/
 /*command is used to  read bootloader version*/
 #define CBL_GET_VER_CMD					(0x10U)
@@ -31,7 +31,7 @@
 /*Command is used to jump  bootloader to sepcific address*/
 #define CBL_GO_TO_ADDR_CMD				(0x14U)
 
- /*Command is used  this command use to  mass erase or sector erase of the user flash*/
+ /*Command is used  this command use to  erase application flash sectors (sector 4 and up)*/
 #define CBL_FLASH_ERASE_CMD				(0x15U)
 
 /*Command is used to write data   to different  memories of mcu*/
@@ -40,6 +40,39 @@
 /* Change Read Out Protection Level */
 #define CBL_CHANGE_ROP_Level_CMD        (0x17U)
 
+/* Calculate SHA-256 of a memory region or of the data written since last request */
+#define CBL_GET_SHA256_CMD				(0x18U)
+
+/* Read , validate or commit the per sector CRC manifest of the application flash */
+#define CBL_SECTOR_MANIFEST_CMD			(0x19U)
+
+/* Report the image slots (validity , boot attempts , version) or clear the boot attempts */
+#define CBL_SLOT_INFO_CMD				(0x1AU)
+
+/* Report the boot timestamps and the phase cycles of the last dispatch of a command */
+#define CBL_GET_TIMING_CMD				(0x1BU)
+
+/* Run a RAM stub loaded in the stub region and report its return value */
+#define CBL_EXEC_RAM_STUB_CMD			(0x1CU)
+
+/* Read flash or SRAM back , reply protected by a CRC */
+#define CBL_MEM_READ_CMD				(0x1DU)
+
+/* Stream an address range as consecutive blocks , acknowledged by a window */
+#define CBL_MEM_DUMP_CMD				(0x1EU)
+
+/* Report whether a flash range is erased */
+#define CBL_BLANK_CHECK_CMD				(0x1FU)
+
+/* Compare host block CRCs with the flash , reply with a bitmap of the blocks that differ */
+#define CBL_BLOCK_DIFF_CMD				(0x20U)
+
+/* Everything the host needs at connection time in one reply */
+#define CBL_GET_DEVICE_INFO_CMD			(0x21U)
+
+/* Negotiate the session parameters (frame size , window , CRC mode , compression , baud rate) */
+#define CBL_SESSION_OPEN_CMD			(0x22U)
+
 		/*       BL Commands end */
 #define CBL_VENDOR_ID			(100U)
 #define CBL_SW_MAJOR_VERSION	(1U)
@@ -56,11 +89,15 @@
 
 
 #define CBL_ACK_REPLY_MSG_LENGTH  		(0x02UL)
+/* The frame body must follow its length byte within this time , a partial frame is dropped so the host can resend */
+#define BL_HOST_FRAME_TIMEOUT_MS		(50UL)
 
-#define FLASH_SECTOR2_BASE_ADDRESS		(0x8008000UL)
+#define FLASH_SECTOR4_BASE_ADDRESS		(0x8010000UL)
 
 #define ADDRESS_IS_VALID			(0x01UL)
 #define ADDRESS_IS_INVALID			(0x00UL)
+/* Image base whose image fails validation or , dual slot , is not the slot the selection starts */
+#define ADDRESS_IS_NOT_BOOTABLE		(0x02UL)
 
 
 #define BL_STM32F401_SRAM_SIZE		(64UL * 1024UL)
@@ -71,8 +108,6 @@
 
 #define BL_STM32401_MAX_FLASH_SECTORS	(0x6UL)
 
-#define BL_FLASH_MASS_ERASE					(0xffU)
-
 #define BL_INVALID_SECTOR_NUMBER			(0x00U)
 #define BL_VALID_SECTOR_NUMBER				(0x01U)
 #define BL_UNSUCCESSFUL_ERASE				(0x02U)
@@ -83,6 +118,10 @@
 #define BL_FLASH_WRITE_FAILED				(0x00U)
 #define BL_FLASH_WRITE_PASSED				(0x01U)
 
+/* CBL_MEM_WRITE_CMD regions : application flash (sector 4 and up) and the RAM stub region */
+#define BL_NUMBER_OF_WRITE_REGIONS			(2U)
+#define BL_INVALID_WRITE_REGION				(0xFFU)
+
 
 #define BL_ROP_LEVEL_0							(0U)
 #define BL_ROP_LEVEL_1							(1U)
@@ -90,12 +129,126 @@
 
 #define ROP_LEVEL_CHANGE_INVALID			(0x00U)
 #define ROP_LEVEL_CHANGE_VALID				(0x01U)
+
+#define BL_SHA256_MODE_REGION				(0x00U)
+#define BL_SHA256_MODE_WRITE_STREAM			(0x01U)
+
+/* Region mode is refused with BL_MEM_READ_RDP_ACTIVE instead while read out protection is set */
+#define BL_SHA256_REQUEST_INVALID			(0x00U)
+#define BL_SHA256_REQUEST_VALID				(0x01U)
+/* request status + digest + number of CPU cycles spent hashing */
+#define BL_SHA256_REPLY_LENGTH				(1U + BL_SHA256_DIGEST_SIZE + 4U)
+
+#define BL_MANIFEST_OP_READ					(0x00U)
+#define BL_MANIFEST_OP_VALIDATE				(0x01U)
+#define BL_MANIFEST_OP_COMMIT				(0x02U)
+
+#define BL_MANIFEST_REQUEST_INVALID			(0x00U)
+#define BL_MANIFEST_REQUEST_VALID			(0x01U)
+/* request status + generation + (sector state + sector CRC) per application sector */
+#define BL_MANIFEST_REPLY_LENGTH			(1U + 4U + (BL_MANIFEST_NUMBER_OF_APP_SECTORS * 5U))
+
+#define BL_SLOT_OP_READ						(0x00U)
+#define BL_SLOT_OP_CLEAR_ATTEMPTS			(0x01U)
+
+#define BL_SLOT_REQUEST_INVALID				(0x00U)
+#define BL_SLOT_REQUEST_VALID				(0x01U)
+/* request status + active slot + (validity + attempts + version + size) per slot */
+#define BL_SLOT_INFO_REPLY_LENGTH			(2U + (BL_BOOT_NUMBER_OF_SLOTS * 10U))
+
+#define BL_MEM_READ_INVALID_ADDRESS			(0x00U)
+#define BL_MEM_READ_PASSED					(0x01U)
+#define BL_MEM_READ_RDP_ACTIVE				(0x02U)
+/* Reply length goes in the one byte ACK : status + data + CRC */
+#define BL_MEM_READ_MAX_LENGTH				(0xFFU - 1U - CRC_TYPE_SIZE)
+
+/* Dump status uses BL_MEM_READ_xx , reply : status + block size + granted window */
+#define BL_DUMP_REPLY_LENGTH				(4U)
+#define BL_DUMP_BLOCK_SIZE					(256U)
+#define BL_DUMP_MAX_WINDOW					(16U)
+/* Host control frame : type + block index + CRC */
+#define BL_DUMP_CTRL_ACK					(0x01U)
+#define BL_DUMP_CTRL_RETRANSMIT				(0x02U)
+#define BL_DUMP_CTRL_ABORT					(0x03U)
+#define BL_DUMP_CTRL_FRAME_LENGTH			(3U + CRC_TYPE_SIZE)
+/* Window full and no control frame for this long -> resend the oldest unacknowledged block */
+#define BL_DUMP_ACK_TIMEOUT_MS				(250UL)
+#define BL_DUMP_MAX_RETRIES					(5U)
+#define BL_DUMP_RX_RING_SIZE				(64U)
+
+#define BL_BLANK_CHECK_INVALID_ADDRESS		(0x00U)
+#define BL_BLANK_CHECK_BLANK				(0x01U)
+#define BL_BLANK_CHECK_NOT_BLANK			(0x02U)
+#define BL_FLASH_ERASED_WORD				(0xFFFFFFFFUL)
+/* status + offset of the first non blank byte */
+#define BL_BLANK_CHECK_REPLY_LENGTH			(5U)
+
+/* Refused with BL_MEM_READ_RDP_ACTIVE instead while read out protection is set */
+#define BL_DIFF_INVALID_REQUEST				(0x00U)
+#define BL_DIFF_PASSED						(0x01U)
+#define BL_DIFF_BLOCK_SIZE					(1024UL)
+/* Pair : block index (2 bytes) + block CRC , as many as one frame holds after base address and pair count */
+#define BL_DIFF_PAIR_SIZE					(2U + CRC_TYPE_SIZE)
+#define BL_DIFF_MAX_PAIRS					(40U)
+#define BL_DIFF_BITMAP_SIZE					((BL_DIFF_MAX_PAIRS + 7U) / 8U)
+/* status + bitmap , bit n set -> block of pair n differs */
+#define BL_DIFF_REPLY_LENGTH				(1U + BL_DIFF_BITMAP_SIZE)
+
+/* Length byte + up to 255 bytes */
+#define BL_MAX_FRAME_SIZE					(256U)
+#define BL_NUMBER_OF_BAUD_RATES				(sizeof((uint32_t[])BL_HOST_BAUD_RATES) / sizeof(uint32_t))
+#define BL_DEVICE_UID_SIZE					(12U)
+/* Build options reported in the device info feature flags */
+#define BL_FEATURE_DUAL_SLOT				(0x00000001UL)
+#define BL_FEATURE_HOST_TX_DMA				(0x00000002UL)
+#define BL_FEATURE_HOST_RX_DMA				(0x00000004UL)
+#define BL_FEATURE_ROP_LEVEL_2				(0x00000008UL)
+#define BL_FEATURE_VALIDATION_CACHE			(0x00000010UL)
+#define BL_FEATURE_BOOT_STRAP				(0x00000020UL)
+#define BL_FEATURE_WORD_CRC					(0x00000040UL)
+#define BL_FEATURE_COMPRESSION				(0x00000080UL)
+/*
+ * version (4) + chip ID (2) + RDP (1) + UID + flash size KB (2) + max frame (2) + feature flags (4)
+ * + image valid , active slot , header present , FW version , image size , image CRC (15)
+ * + number of baud rates + baud rates + number of commands + commands
+ * */
+#define BL_DEVICE_INFO_FIXED_LENGTH			(30U + BL_DEVICE_UID_SIZE)
+#define BL_DEVICE_INFO_REPLY_LENGTH			(BL_DEVICE_INFO_FIXED_LENGTH + 1U + (BL_NUMBER_OF_BAUD_RATES * 4U) + 1U + BL_NUMBER_OF_COMMAND)
+
+/* Frame CRC : one engine word per byte (default) or the frame packed in little endian words , zero padded */
+#define BL_SESSION_CRC_BYTE					(0x00U)
+#define BL_SESSION_CRC_WORD					(0x01U)
+#define BL_SESSION_COMPRESSION_OFF			(0x00U)
+#define BL_SESSION_COMPRESSION_ON			(0x01U)
+#define BL_SESSION_MIN_FRAME_SIZE			(16U)
+#ifdef BL_ENABLE_HOST_RX_DMA
+#define BL_SESSION_MAX_WINDOW				(BL_DUMP_MAX_WINDOW)
+#else
+/* Control frames are only received while waiting , one block in flight */
+#define BL_SESSION_MAX_WINDOW				(1U)
+#endif
+#define BL_SESSION_OPENED					(0x01U)
+#define BL_SESSION_DEFAULTS					{BL_MAX_FRAME_SIZE , BL_SESSION_MAX_WINDOW , BL_SESSION_CRC_BYTE , BL_SESSION_COMPRESSION_OFF}
+/* Link state : no session , session waiting for its first good frame , confirmed session */
+#define BL_SESSION_STATE_DEFAULT			(0x00U)
+#define BL_SESSION_STATE_PENDING			(0x01U)
+#define BL_SESSION_STATE_OPEN				(0x02U)
+/* status + frame size (2) + window + CRC mode + compression + baud rate (4) */
+#define BL_SESSION_REPLY_LENGTH				(10U)
+
+#define BL_TIMING_REQUEST_INVALID			(0x00U)
+#define BL_TIMING_REQUEST_VALID				(0x01U)
+/* request status + boot timestamps + decision cycles + count + phases + total */
+#define BL_TIMING_REPLY_LENGTH				(1U + (BL_BOOT_NUMBER_OF_TIMESTAMPS * 4U) + 4U + 4U + (BL_TIMING_NUMBER_OF_PHASES * 4U) + 4U)
+
+/* stub status + stub return value */
+#define BL_STUB_REPLY_LENGTH				(1U + 4U)
 /* ----------------------- MACROS END ------------------------ */
 
 /* ----------------------- Macro Functions Start -------------- */
 #define BL_COMMAND_TO_ARR_IDX(_COMMAND)	((uint8_t)((_COMMAND) - 0x10U))
 
-#define IS_BL_COMMAND(_COMMAND)			((CBL_GET_VER_CMD <=  (_COMMAND)) && (CBL_CHANGE_ROP_Level_CMD >=  (_COMMAND)))
+#define IS_BL_COMMAND(_COMMAND)			((CBL_GET_VER_CMD <=  (_COMMAND)) && (CBL_SESSION_OPEN_CMD >=  (_COMMAND)))
 
 /* ----------------------- Macro Function End ----------------- */
 
@@ -103,6 +256,21 @@
 typedef void(*pMainApp)(void);
 typedef void(*BL_HelperCommandpFunc)(void);
 typedef void(*pJumpAddressFunc)(void);
+typedef uint8_t(*BL_MemoryWritepFunc)(uint8_t* pDataBuffer , uint8_t DataLen , uint32_t StartMemAddress);
+
+typedef struct {
+	uint32_t BaseAddress;
+	uint32_t EndAddress;				/* First address after the region */
+	BL_MemoryWritepFunc pWriteFunc;
+}BL_Write_Region_t;
+
+/* Parameters negotiated by CBL_SESSION_OPEN_CMD , defaults are the protocol of hosts that never open a session */
+typedef struct {
+	uint16_t FrameSize;
+	uint8_t  Window;
+	uint8_t  CRCMode;
+	uint8_t  Compression;
+}BL_Session_t;
 /* ----------------------- User Data Types End ---------------- */
 
 /* ----------------------- Software Interfaces Start ---------- */